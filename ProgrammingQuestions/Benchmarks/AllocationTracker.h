@@ -0,0 +1,391 @@
+// Heap allocation tracking: counts of the global operator new / delete calls of every thread, scoped regions that
+// report what was allocated inside them (and from where), and FrameAllocationGuard for the code that must not allocate
+// at all (the coin pool after init, per frame spline sampling)
+//
+//   AllocationScope scope("load level", true);     // true also records the call sites
+//   ...
+//   AllocationStats stats = scope.getStats();      // allocations, deallocations and bytes since the scope started
+//   std::string text = scope.report();             // the same with the call sites that allocated the most
+//
+//   void tick() {
+//       FrameAllocationGuard guard("coin pool update");   // a budget of 0 allocations
+//       pool.update();
+//   }                                                     // fails here if update() allocated
+//
+// The counters only move when the replacement operators are in the program: define ALLOCATION_TRACKER_HOOKS before
+// including this header in exactly one .cpp (the one with main). Without it everything still compiles, the counts stay
+// 0 and AllocationTracker::isInstalled() is false.
+// A hook costs two thread_local additions per new or delete, plus a search of a 16 entry table inside the scopes that
+// record call sites, so the hooks can stay in profiling builds. Nothing allocates while counting (the call site tables
+// are arrays inside the scopes); only report() builds strings.
+// The counts are per thread, a scope sees the allocations of the thread it was created on. Scopes must end in the
+// reverse order they started (as locals do), and a scope that records call sites passes them on to the recording scope
+// around it when it ends.
+//
+// A guard that goes over its budget fails when it is destroyed by calling the failure handler with its report. The
+// default handler prints the report and aborts, like a failed assert, so a test or a profiling run stops at the frame
+// that allocated; setFailureHandler replaces it. check() ends the guard early and throws std::logic_error instead,
+// which suits tests that want to catch the failure.
+// Call sites are the return addresses of operator new, printed as function+offset (module) with dladdr on Linux and
+// macOS (link with -rdynamic to get the names of the executable's own functions, and -ldl before glibc 2.34) and as
+// plain addresses elsewhere. For containers that is usually the member that grew (std::vector<...>::_M_realloc_insert);
+// the scope names tell which code called it.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <algorithm>
+#include <array>
+#include <new>
+#include <stdexcept>
+#include <string>
+
+#if defined(__linux__) || defined(__APPLE__)
+#include <dlfcn.h>
+#endif
+#if defined(__GNUC__) || defined(__clang__)
+#include <cxxabi.h>
+#define ALLOCATION_TRACKER_CALLER() __builtin_return_address(0)
+#elif defined(_MSC_VER)
+#include <intrin.h>
+#define ALLOCATION_TRACKER_CALLER() _ReturnAddress()
+#else
+#define ALLOCATION_TRACKER_CALLER() nullptr
+#endif
+
+struct AllocationStats {
+    std::uint64_t allocations = 0;
+    std::uint64_t deallocations = 0;
+    std::uint64_t bytesAllocated = 0;       // as requested from operator new
+
+    AllocationStats operator-(const AllocationStats& other) const {
+        AllocationStats difference;
+        difference.allocations = allocations - other.allocations;
+        difference.deallocations = deallocations - other.deallocations;
+        difference.bytesAllocated = bytesAllocated - other.bytesAllocated;
+        return difference;
+    }
+};
+
+struct AllocationCallSite {
+    const void* address = nullptr;
+    std::uint64_t allocations = 0;
+    std::uint64_t bytes = 0;
+};
+
+class AllocationScope;
+
+namespace AllocationTracker {
+
+    // what the hooks write, one per thread (constant initialized, so the thread_local needs no initialization guard)
+    struct ThreadState {
+        AllocationStats stats;
+        AllocationScope* recordingScope = nullptr;      // innermost scope that records call sites
+    };
+
+    inline ThreadState& getThreadState() {
+        thread_local ThreadState state;
+        return state;
+    }
+
+    // totals of this thread since it started
+    inline AllocationStats getThreadStats() {
+        return getThreadState().stats;
+    }
+
+    inline bool& installedFlag() {
+        static bool installed = false;
+        return installed;
+    }
+
+    // true when the replacement operators (ALLOCATION_TRACKER_HOOKS) are linked in
+    inline bool isInstalled() {
+        return installedFlag();
+    }
+
+    typedef void (*FailureHandler)(const std::string& report);
+
+    inline void abortOnFailure(const std::string& report) {
+        std::fputs(report.c_str(), stderr);
+        std::fflush(stderr);
+        std::abort();
+    }
+
+    inline FailureHandler& failureHandler() {
+        static FailureHandler handler = abortOnFailure;
+        return handler;
+    }
+
+    // What a FrameAllocationGuard over budget calls, returns the previous handler
+    inline FailureHandler setFailureHandler(FailureHandler handler) {
+        FailureHandler previous = failureHandler();
+        failureHandler() = handler ? handler : abortOnFailure;
+        return previous;
+    }
+
+    inline void recordAllocation(std::size_t size, const void* caller);
+
+    inline void recordDeallocation() {
+        ++getThreadState().stats.deallocations;
+    }
+
+    // function+offset (module) for a code address where the platform can tell, the address otherwise
+    inline std::string describeAddress(const void* address) {
+        char text[64];
+        std::snprintf(text, sizeof(text), "%p", address);
+        std::string description = text;
+#if defined(__linux__) || defined(__APPLE__)
+        Dl_info info;
+        if (address && dladdr(address, &info)) {
+            std::string module = info.dli_fname ? info.dli_fname : "?";
+            module = module.substr(module.find_last_of('/') + 1);
+            if (info.dli_sname) {
+                std::string name = info.dli_sname;
+#if defined(__GNUC__) || defined(__clang__)
+                int status = 0;
+                char* demangled = abi::__cxa_demangle(info.dli_sname, nullptr, nullptr, &status);
+                if (status == 0 && demangled) name = demangled;
+                std::free(demangled);
+#endif
+                std::snprintf(text, sizeof(text), "+0x%zx", static_cast<std::size_t>(static_cast<const char*>(address) - static_cast<const char*>(info.dli_saddr)));
+                description = name + text + " (" + module + ")";
+            }
+            else {
+                std::snprintf(text, sizeof(text), "+0x%zx", static_cast<std::size_t>(static_cast<const char*>(address) - static_cast<const char*>(info.dli_fbase)));
+                description = module + text;
+            }
+        }
+#endif
+        return description;
+    }
+}
+
+// The allocations of this thread from construction to end() or destruction
+class AllocationScope {
+public:
+    static constexpr std::size_t maxCallSites = 16;
+
+private:
+    const char* name;
+    AllocationStats start;
+    AllocationStats finish;
+    bool active = true;
+    bool recording;
+    AllocationScope* outerRecordingScope = nullptr;
+    std::array<AllocationCallSite, maxCallSites> callSites;
+    std::size_t callSiteCount = 0;
+    std::uint64_t unrecordedAllocations = 0;     // from call sites that did not fit in the table
+
+public:
+    explicit AllocationScope(const char* name = "", bool recordCallSites = false) : name(name), recording(recordCallSites), callSites() {
+        AllocationTracker::ThreadState& state = AllocationTracker::getThreadState();
+        if (recording) {
+            outerRecordingScope = state.recordingScope;
+            state.recordingScope = this;
+        }
+        start = state.stats;
+    }
+
+    ~AllocationScope() { end(); }
+
+    AllocationScope(const AllocationScope&) = delete;
+    AllocationScope& operator=(const AllocationScope&) = delete;
+
+    // Stops counting, getStats() keeps the totals up to here
+    void end() {
+        if (!active) return;
+        AllocationTracker::ThreadState& state = AllocationTracker::getThreadState();
+        finish = state.stats;
+        active = false;
+        if (!recording) return;
+        state.recordingScope = outerRecordingScope;
+        if (outerRecordingScope) {
+            for (std::size_t i = 0; i < callSiteCount; ++i)
+                outerRecordingScope->addCallSite(callSites[i].address, callSites[i].allocations, callSites[i].bytes);
+            outerRecordingScope->unrecordedAllocations += unrecordedAllocations;
+        }
+    }
+
+    const char* getName() const { return name; }
+    bool isActive() const { return active; }
+
+    AllocationStats getStats() const {
+        return (active ? AllocationTracker::getThreadState().stats : finish) - start;
+    }
+
+    std::size_t getCallSiteCount() const { return callSiteCount; }
+    const AllocationCallSite& getCallSite(std::size_t index) const {
+        if (index >= callSiteCount) throw std::out_of_range("AllocationScope::getCallSite index out of range");
+        return callSites[index];
+    }
+    std::uint64_t getUnrecordedAllocations() const { return unrecordedAllocations; }
+
+    // Called by the hooks, adds to the entry of the call site (or to the unrecorded count when the table is full)
+    void addCallSite(const void* address, std::uint64_t allocations, std::uint64_t bytes) {
+        for (std::size_t i = 0; i < callSiteCount; ++i) {
+            if (callSites[i].address == address) {
+                callSites[i].allocations += allocations;
+                callSites[i].bytes += bytes;
+                return;
+            }
+        }
+        if (callSiteCount == maxCallSites) {
+            unrecordedAllocations += allocations;
+            return;
+        }
+        callSites[callSiteCount].address = address;
+        callSites[callSiteCount].allocations = allocations;
+        callSites[callSiteCount].bytes = bytes;
+        ++callSiteCount;
+    }
+
+    // The totals, then the call sites with the most allocations first
+    std::string report() const {
+        AllocationStats stats = getStats();
+        std::string text = std::string("Allocations in \"") + name + "\": " + std::to_string(stats.allocations) + " allocations ("
+            + std::to_string(stats.bytesAllocated) + " bytes), " + std::to_string(stats.deallocations) + " deallocations\n";
+        std::array<AllocationCallSite, maxCallSites> sorted = callSites;
+        std::sort(sorted.begin(), sorted.begin() + callSiteCount,
+            [](const AllocationCallSite& a, const AllocationCallSite& b) { return a.allocations > b.allocations; });
+        for (std::size_t i = 0; i < callSiteCount; ++i) {
+            text += "  " + std::to_string(sorted[i].allocations) + " x (" + std::to_string(sorted[i].bytes) + " bytes) at "
+                + AllocationTracker::describeAddress(sorted[i].address) + "\n";
+        }
+        if (unrecordedAllocations > 0) text += "  " + std::to_string(unrecordedAllocations) + " more from other call sites\n";
+        if (!AllocationTracker::isInstalled()) text += "  (allocation tracking is not installed, define ALLOCATION_TRACKER_HOOKS in one .cpp)\n";
+        return text;
+    }
+};
+
+inline void AllocationTracker::recordAllocation(std::size_t size, const void* caller) {
+    ThreadState& state = getThreadState();
+    ++state.stats.allocations;
+    state.stats.bytesAllocated += size;
+    if (state.recordingScope) state.recordingScope->addCallSite(caller, 1, size);
+}
+
+// A region of a hot path that may allocate at most a budget of times (0 by default), fails on destruction otherwise
+class FrameAllocationGuard {
+private:
+    AllocationScope scope;
+    std::uint64_t allocationBudget;
+    bool checked = false;
+
+public:
+    explicit FrameAllocationGuard(const char* name, std::uint64_t allocationBudget = 0)
+        : scope(name, true), allocationBudget(allocationBudget) {}
+
+    ~FrameAllocationGuard() {
+        scope.end();
+        if (!checked && !isWithinBudget()) AllocationTracker::failureHandler()(report());
+    }
+
+    FrameAllocationGuard(const FrameAllocationGuard&) = delete;
+    FrameAllocationGuard& operator=(const FrameAllocationGuard&) = delete;
+
+    std::uint64_t getAllocationBudget() const { return allocationBudget; }
+    AllocationStats getStats() const { return scope.getStats(); }
+    bool isWithinBudget() const { return scope.getStats().allocations <= allocationBudget; }
+
+    std::string report() const {
+        return scope.report() + "  budget: " + std::to_string(allocationBudget) + " allocations\n";
+    }
+
+    // Ends the guard now, throws std::logic_error with the report if it went over budget
+    void check() {
+        scope.end();
+        checked = true;
+        if (!isWithinBudget()) throw std::logic_error(report());
+    }
+};
+
+#ifdef ALLOCATION_TRACKER_HOOKS
+
+// The replacement global operators, all of them so that every form of new and delete is counted. Memory comes from
+// malloc (and aligned_alloc / _aligned_malloc for the over-aligned forms), failures go through the new handler like the
+// standard operators.
+
+namespace AllocationTracker {
+
+    inline void* allocate(std::size_t size, std::size_t alignment, const void* caller) {
+        if (size == 0) size = 1;
+        recordAllocation(size, caller);
+        while (true) {
+            void* memory;
+            if (alignment <= alignof(std::max_align_t)) memory = std::malloc(size);
+#ifdef _WIN32
+            else memory = _aligned_malloc(size, alignment);
+#else
+            else memory = std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+#endif
+            if (memory) return memory;
+            std::new_handler handler = std::get_new_handler();
+            if (!handler) throw std::bad_alloc();
+            handler();
+        }
+    }
+
+    inline void* allocateNoThrow(std::size_t size, std::size_t alignment, const void* caller) noexcept {
+        try {
+            return allocate(size, alignment, caller);
+        }
+        catch (...) {
+            return nullptr;
+        }
+    }
+
+    inline void deallocate(void* memory, std::size_t alignment) noexcept {
+        if (!memory) return;
+        recordDeallocation();
+#ifdef _WIN32
+        if (alignment > alignof(std::max_align_t)) {
+            _aligned_free(memory);
+            return;
+        }
+#else
+        (void)alignment;
+#endif
+        std::free(memory);
+    }
+
+    static const bool hooksInstalled = (installedFlag() = true);
+}
+
+void* operator new(std::size_t size) { return AllocationTracker::allocate(size, 0, ALLOCATION_TRACKER_CALLER()); }
+void* operator new[](std::size_t size) { return AllocationTracker::allocate(size, 0, ALLOCATION_TRACKER_CALLER()); }
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept { return AllocationTracker::allocateNoThrow(size, 0, ALLOCATION_TRACKER_CALLER()); }
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept { return AllocationTracker::allocateNoThrow(size, 0, ALLOCATION_TRACKER_CALLER()); }
+void* operator new(std::size_t size, std::align_val_t alignment) {
+    return AllocationTracker::allocate(size, static_cast<std::size_t>(alignment), ALLOCATION_TRACKER_CALLER());
+}
+void* operator new[](std::size_t size, std::align_val_t alignment) {
+    return AllocationTracker::allocate(size, static_cast<std::size_t>(alignment), ALLOCATION_TRACKER_CALLER());
+}
+void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    return AllocationTracker::allocateNoThrow(size, static_cast<std::size_t>(alignment), ALLOCATION_TRACKER_CALLER());
+}
+void* operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    return AllocationTracker::allocateNoThrow(size, static_cast<std::size_t>(alignment), ALLOCATION_TRACKER_CALLER());
+}
+
+void operator delete(void* memory) noexcept { AllocationTracker::deallocate(memory, 0); }
+void operator delete[](void* memory) noexcept { AllocationTracker::deallocate(memory, 0); }
+void operator delete(void* memory, std::size_t) noexcept { AllocationTracker::deallocate(memory, 0); }
+void operator delete[](void* memory, std::size_t) noexcept { AllocationTracker::deallocate(memory, 0); }
+void operator delete(void* memory, const std::nothrow_t&) noexcept { AllocationTracker::deallocate(memory, 0); }
+void operator delete[](void* memory, const std::nothrow_t&) noexcept { AllocationTracker::deallocate(memory, 0); }
+void operator delete(void* memory, std::align_val_t alignment) noexcept { AllocationTracker::deallocate(memory, static_cast<std::size_t>(alignment)); }
+void operator delete[](void* memory, std::align_val_t alignment) noexcept { AllocationTracker::deallocate(memory, static_cast<std::size_t>(alignment)); }
+void operator delete(void* memory, std::size_t, std::align_val_t alignment) noexcept { AllocationTracker::deallocate(memory, static_cast<std::size_t>(alignment)); }
+void operator delete[](void* memory, std::size_t, std::align_val_t alignment) noexcept { AllocationTracker::deallocate(memory, static_cast<std::size_t>(alignment)); }
+void operator delete(void* memory, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    AllocationTracker::deallocate(memory, static_cast<std::size_t>(alignment));
+}
+void operator delete[](void* memory, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    AllocationTracker::deallocate(memory, static_cast<std::size_t>(alignment));
+}
+
+#endif
@@ -0,0 +1,457 @@
+// Small benchmark harness for Benchmarks.cpp, modelled on the Google Benchmark API (the same macros, loop and JSON,
+// with this repo's naming) so the benchmarks would move to the real library with little more than renames:
+//   void addTriangles(BenchmarkState& state) { for (auto _ : state) { ... } }
+//   BENCHMARK(addTriangles)->arg(1000)->arg(10000);
+//   BENCHMARK_F(CoinPoolFixture, churn)(BenchmarkState& state) { for (auto _ : state) { ... } }
+// Every benchmark runs once and is then repeated with more iterations (estimated from the time taken so far) until
+// it has run for at least the minimum time. Results are printed as a table and can be written as JSON in the Google
+// Benchmark format (context + benchmarks with name, iterations, real_time, cpu_time, time_unit and the counters), so
+// Google's tools/compare.py can diff two runs for regressions.
+// Hardware counters (cycles, instructions, branch and cache misses per iteration) come from perf_event_open on Linux.
+// They are left out when the kernel does not allow them (containers, perf_event_paranoid) or on other systems.
+// With a BenchmarkMemoryManager registered (Benchmarks.cpp registers one over AllocationTracker.h), the allocations of
+// the timed part of every run are reported as allocs_per_iter and bytes_allocated_per_iter.
+//
+// Command line (same names as Google Benchmark):
+//   --benchmark_filter=<regex>   run only the benchmarks whose name matches
+//   --benchmark_min_time=<s>     minimum time per benchmark, 0.5 s by default
+//   --benchmark_out=<file>       also write the JSON to file
+//   --benchmark_format=json      print the JSON instead of the table
+//   --benchmark_list_tests       print the benchmark names only
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <algorithm>
+#include <functional>
+#include <map>
+#include <memory>
+#include <regex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// Keeps the compiler from removing a computation whose result is otherwise unused
+template <typename T>
+inline void doNotOptimize(const T& value) {
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    static volatile const void* sink;
+    sink = &value;
+#endif
+}
+
+// Cycles, instructions, branch misses and cache misses of this thread, counted together as one perf event group
+class HardwareCounters {
+public:
+    static constexpr int count = 4;
+    static constexpr const char* names[count] = { "cycles", "instructions", "branch_misses", "cache_misses" };
+
+private:
+    int descriptors[count] = { -1, -1, -1, -1 };
+    bool available = false;
+
+public:
+    HardwareCounters() {
+#ifdef __linux__
+        const std::uint64_t configs[count] = { PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_BRANCH_MISSES, PERF_COUNT_HW_CACHE_MISSES };
+        available = true;
+        for (int i = 0; i < count && available; ++i) {
+            perf_event_attr attributes;
+            std::memset(&attributes, 0, sizeof(attributes));
+            attributes.type = PERF_TYPE_HARDWARE;
+            attributes.size = sizeof(attributes);
+            attributes.config = configs[i];
+            attributes.disabled = i == 0;         // the group leader starts and stops all of them
+            attributes.exclude_kernel = 1;
+            attributes.exclude_hv = 1;
+            descriptors[i] = static_cast<int>(syscall(SYS_perf_event_open, &attributes, 0, -1, i == 0 ? -1 : descriptors[0], 0));
+            available = descriptors[i] >= 0;
+        }
+        if (!available) close();
+#endif
+    }
+
+    ~HardwareCounters() { close(); }
+    HardwareCounters(const HardwareCounters&) = delete;
+    HardwareCounters& operator=(const HardwareCounters&) = delete;
+
+    bool isAvailable() const { return available; }
+
+    void start() {
+#ifdef __linux__
+        if (available) ioctl(descriptors[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+#endif
+    }
+
+    void stop() {
+#ifdef __linux__
+        if (available) ioctl(descriptors[0], PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+#endif
+    }
+
+    // the counts since the last reset
+    void read(std::uint64_t* totals) const {
+#ifdef __linux__
+        for (int i = 0; i < count && available; ++i) {
+            std::uint64_t value = 0;
+            if (::read(descriptors[i], &value, sizeof(value)) == sizeof(value)) totals[i] = value;
+        }
+#else
+        (void)totals;
+#endif
+    }
+
+    void reset() {
+#ifdef __linux__
+        if (available) ioctl(descriptors[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+#endif
+    }
+
+private:
+    void close() {
+#ifdef __linux__
+        for (int& descriptor : descriptors) {
+            if (descriptor >= 0) ::close(descriptor);
+            descriptor = -1;
+        }
+#endif
+        available = false;
+    }
+};
+
+// Counts allocations for the benchmarks, like Google's benchmark::MemoryManager. start() and stop() bracket the timed
+// part of a run (the loop, without setUp or paused sections), stop() adds what was allocated since start() to result.
+class BenchmarkMemoryManager {
+public:
+    struct Result {
+        std::int64_t allocations = 0;
+        std::int64_t bytesAllocated = 0;
+    };
+
+    virtual ~BenchmarkMemoryManager() = default;
+    virtual void start() = 0;
+    virtual void stop(Result& result) = 0;
+};
+
+inline BenchmarkMemoryManager*& benchmarkMemoryManager() {
+    static BenchmarkMemoryManager* manager = nullptr;
+    return manager;
+}
+
+inline void registerMemoryManager(BenchmarkMemoryManager* manager) {
+    benchmarkMemoryManager() = manager;
+}
+
+// What a benchmark function gets: the iteration loop, its argument, and counters to report
+class BenchmarkState {
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    std::size_t maxIterations;
+    std::int64_t argument;
+    HardwareCounters* hardware;
+    BenchmarkMemoryManager* memory;
+    BenchmarkMemoryManager::Result memoryResult;
+    Clock::time_point realStart;
+    std::clock_t cpuStart = 0;
+    double realSeconds = 0;
+    double cpuSeconds = 0;
+    bool running = false;
+
+public:
+    std::map<std::string, double> counters;     // reported per benchmark (not per iteration), like Google's state.counters
+    std::int64_t itemsProcessed = 0;
+    std::int64_t bytesProcessed = 0;
+
+    BenchmarkState(std::size_t iterations, std::int64_t argument, HardwareCounters* hardware, BenchmarkMemoryManager* memory = nullptr)
+        : maxIterations(iterations), argument(argument), hardware(hardware), memory(memory) {}
+
+    std::size_t iterations() const { return maxIterations; }
+    std::int64_t range(int = 0) const { return argument; }
+    double getRealSeconds() const { return realSeconds; }
+    double getCpuSeconds() const { return cpuSeconds; }
+    const BenchmarkMemoryManager::Result& getMemoryResult() const { return memoryResult; }
+
+    void setItemsProcessed(std::int64_t items) { itemsProcessed = items; }
+    void setBytesProcessed(std::int64_t bytes) { bytesProcessed = bytes; }
+
+    // Stops the clocks for setup work inside the loop
+    void pauseTiming() {
+        if (!running) return;
+        if (hardware) hardware->stop();
+        realSeconds += std::chrono::duration<double>(Clock::now() - realStart).count();
+        cpuSeconds += static_cast<double>(std::clock() - cpuStart) / CLOCKS_PER_SEC;
+        if (memory) memory->stop(memoryResult);
+        running = false;
+    }
+
+    void resumeTiming() {
+        if (running) return;
+        running = true;
+        if (memory) memory->start();
+        cpuStart = std::clock();
+        realStart = Clock::now();
+        if (hardware) hardware->start();
+    }
+
+    // what the loop variable holds, nothing (and marked so the unused loop variable does not warn)
+    struct [[maybe_unused]] Value {};
+
+    // for (auto _ : state) runs the body iterations() times with the clocks running
+    struct Iterator {
+        BenchmarkState* state;
+        std::size_t left;
+
+        bool operator!=(const Iterator&) {
+            if (left > 0) return true;
+            state->pauseTiming();
+            return false;
+        }
+        void operator++() { --left; }
+        Value operator*() const { return Value(); }
+    };
+
+    Iterator begin() {
+        resumeTiming();
+        return { this, maxIterations };
+    }
+    Iterator end() { return { this, 0 }; }
+};
+
+// Base class for BENCHMARK_F, setUp / tearDown run around every measured run (not every iteration)
+class BenchmarkFixture {
+public:
+    virtual ~BenchmarkFixture() = default;
+    virtual void setUp(BenchmarkState&) {}
+    virtual void tearDown(BenchmarkState&) {}
+    virtual void run(BenchmarkState& state) = 0;
+};
+
+class Benchmark {
+public:
+    typedef std::function<void(BenchmarkState&)> Function;
+
+private:
+    std::string name;
+    Function function;
+    std::vector<std::int64_t> arguments;
+
+public:
+    Benchmark(std::string name, Function function) : name(std::move(name)), function(std::move(function)) {}
+
+    Benchmark* arg(std::int64_t argument) {
+        arguments.push_back(argument);
+        return this;
+    }
+
+    const std::string& getName() const { return name; }
+    const Function& getFunction() const { return function; }
+    const std::vector<std::int64_t>& getArguments() const { return arguments; }
+};
+
+inline std::vector<std::unique_ptr<Benchmark>>& benchmarkRegistry() {
+    static std::vector<std::unique_ptr<Benchmark>> benchmarks;
+    return benchmarks;
+}
+
+inline Benchmark* registerBenchmark(const std::string& name, Benchmark::Function function) {
+    benchmarkRegistry().emplace_back(new Benchmark(name, std::move(function)));
+    return benchmarkRegistry().back().get();
+}
+
+#define BENCHMARK_CONCAT_INNER(a, b) a##b
+#define BENCHMARK_CONCAT(a, b) BENCHMARK_CONCAT_INNER(a, b)
+
+#define BENCHMARK(function) \
+    static Benchmark* BENCHMARK_CONCAT(benchmark_, __LINE__) = registerBenchmark(#function, function)
+
+#define BENCHMARK_F(Fixture, Name)                                                                              \
+    class Fixture##_##Name : public Fixture {                                                                   \
+    public:                                                                                                     \
+        void run(BenchmarkState& state) override;                                                               \
+    };                                                                                                          \
+    static Benchmark* BENCHMARK_CONCAT(benchmark_, __LINE__) = registerBenchmark(#Fixture "/" #Name,            \
+        [](BenchmarkState& state) {                                                                             \
+            Fixture##_##Name fixture;                                                                           \
+            fixture.setUp(state);                                                                               \
+            fixture.run(state);                                                                                 \
+            fixture.tearDown(state);                                                                            \
+        });                                                                                                     \
+    void Fixture##_##Name::run
+
+// One measured benchmark (one argument of one registered function)
+struct BenchmarkResult {
+    std::string name;
+    std::size_t familyIndex = 0;
+    std::size_t instanceIndex = 0;
+    std::size_t iterations = 0;
+    double realTime = 0;            // nanoseconds per iteration
+    double cpuTime = 0;
+    std::map<std::string, double> counters;
+};
+
+// Runs every registered benchmark that matches the command line and reports the results, returns the exit code
+inline int runBenchmarks(int argc, char** argv) {
+    std::string filter = ".*", out, format = "console";
+    double minTime = 0.5;
+    bool listOnly = false;
+    for (int i = 1; i < argc; ++i) {
+        std::string option = argv[i];
+        auto value = [&](const char* prefix) { return option.compare(0, std::strlen(prefix), prefix) == 0 ? option.substr(std::strlen(prefix)) : std::string(); };
+        if (!value("--benchmark_filter=").empty()) filter = value("--benchmark_filter=");
+        else if (!value("--benchmark_min_time=").empty()) minTime = std::stod(value("--benchmark_min_time="));
+        else if (!value("--benchmark_out=").empty()) out = value("--benchmark_out=");
+        else if (!value("--benchmark_format=").empty()) format = value("--benchmark_format=");
+        else if (option == "--benchmark_list_tests") listOnly = true;
+        else {
+            std::fprintf(stderr, "Unknown option %s\n", option.c_str());
+            return 1;
+        }
+    }
+    std::regex pattern(filter);
+
+    HardwareCounters hardware;
+    std::vector<BenchmarkResult> results;
+    bool console = format != "json";
+    if (console && !listOnly) {
+        std::printf("%-44s %14s %14s %12s\n", "Benchmark", "Time (ns)", "CPU (ns)", "Iterations");
+        std::printf("%s\n", std::string(87, '-').c_str());
+    }
+
+    std::size_t familyIndex = 0;
+    for (const std::unique_ptr<Benchmark>& benchmark : benchmarkRegistry()) {
+        std::vector<std::int64_t> arguments = benchmark->getArguments();
+        bool hasArgument = !arguments.empty();
+        if (!hasArgument) arguments.push_back(0);
+
+        std::size_t instanceIndex = 0;
+        bool matched = false;
+        for (std::int64_t argument : arguments) {
+            std::string name = benchmark->getName() + (hasArgument ? "/" + std::to_string(argument) : "");
+            if (!std::regex_search(name, pattern)) continue;
+            matched = true;
+            if (listOnly) {
+                std::printf("%s\n", name.c_str());
+                continue;
+            }
+
+            // grow the iteration count until one run takes at least minTime, like Google Benchmark
+            std::size_t iterations = 1;
+            std::unique_ptr<BenchmarkState> state;
+            std::uint64_t hardwareTotals[HardwareCounters::count] = {};
+            while (true) {
+                hardware.reset();
+                state.reset(new BenchmarkState(iterations, argument, hardware.isAvailable() ? &hardware : nullptr, benchmarkMemoryManager()));
+                benchmark->getFunction()(*state);
+                double seconds = state->getRealSeconds();
+                if (seconds >= minTime || iterations >= 1000000000) break;
+                double multiplier = seconds > 0 ? std::min(10.0, std::max(1.4 * minTime / seconds, 1.1)) : 10.0;
+                iterations = static_cast<std::size_t>(iterations * multiplier) + 1;
+            }
+            hardware.read(hardwareTotals);
+
+            BenchmarkResult result;
+            result.name = name;
+            result.familyIndex = familyIndex;
+            result.instanceIndex = instanceIndex++;
+            result.iterations = iterations;
+            result.realTime = state->getRealSeconds() * 1e9 / iterations;
+            result.cpuTime = state->getCpuSeconds() * 1e9 / iterations;
+            result.counters = state->counters;
+            if (state->itemsProcessed > 0 && state->getRealSeconds() > 0) result.counters["items_per_second"] = state->itemsProcessed / state->getRealSeconds();
+            if (state->bytesProcessed > 0 && state->getRealSeconds() > 0) result.counters["bytes_per_second"] = state->bytesProcessed / state->getRealSeconds();
+            if (hardware.isAvailable()) {
+                for (int i = 0; i < HardwareCounters::count; ++i)
+                    result.counters[HardwareCounters::names[i]] = static_cast<double>(hardwareTotals[i]) / iterations;
+            }
+            if (benchmarkMemoryManager()) {
+                result.counters["allocs_per_iter"] = static_cast<double>(state->getMemoryResult().allocations) / iterations;
+                result.counters["bytes_allocated_per_iter"] = static_cast<double>(state->getMemoryResult().bytesAllocated) / iterations;
+            }
+            results.push_back(result);
+
+            if (console) {
+                std::printf("%-44s %14.1f %14.1f %12zu", result.name.c_str(), result.realTime, result.cpuTime, result.iterations);
+                for (const auto& counter : result.counters) std::printf(" %s=%.4g", counter.first.c_str(), counter.second);
+                std::printf("\n");
+                std::fflush(stdout);
+            }
+        }
+        if (matched) ++familyIndex;
+    }
+    if (listOnly) return 0;
+
+    // the JSON, in the layout of Google Benchmark's --benchmark_format=json
+    std::ostringstream json;
+    char date[64] = "";
+    std::time_t now = std::time(nullptr);
+    std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", std::localtime(&now));
+    char host[256] = "unknown";
+#ifdef __linux__
+    gethostname(host, sizeof(host) - 1);
+#endif
+    auto escape = [](const std::string& text) {
+        std::string escaped;
+        for (char c : text) {
+            if (c == '"' || c == '\\') escaped += '\\';
+            escaped += c;
+        }
+        return escaped;
+    };
+    json.precision(17);
+    json << "{\n  \"context\": {\n";
+    json << "    \"date\": \"" << date << "\",\n";
+    json << "    \"host_name\": \"" << escape(host) << "\",\n";
+    json << "    \"executable\": \"" << escape(argc > 0 ? argv[0] : "") << "\",\n";
+    json << "    \"num_cpus\": " << std::max(1u, std::thread::hardware_concurrency()) << ",\n";
+#ifdef NDEBUG
+    json << "    \"library_build_type\": \"release\",\n";
+#else
+    json << "    \"library_build_type\": \"debug\",\n";
+#endif
+    json << "    \"hardware_counters\": " << (hardware.isAvailable() ? "true" : "false") << "\n  },\n";
+    json << "  \"benchmarks\": [\n";
+    for (std::size_t i = 0; i < results.size(); ++i) {
+        const BenchmarkResult& result = results[i];
+        json << "    {\n";
+        json << "      \"name\": \"" << escape(result.name) << "\",\n";
+        json << "      \"family_index\": " << result.familyIndex << ",\n";
+        json << "      \"per_family_instance_index\": " << result.instanceIndex << ",\n";
+        json << "      \"run_name\": \"" << escape(result.name) << "\",\n";
+        json << "      \"run_type\": \"iteration\",\n";
+        json << "      \"repetitions\": 1,\n      \"repetition_index\": 0,\n      \"threads\": 1,\n";
+        json << "      \"iterations\": " << result.iterations << ",\n";
+        json << "      \"real_time\": " << result.realTime << ",\n";
+        json << "      \"cpu_time\": " << result.cpuTime << ",\n";
+        json << "      \"time_unit\": \"ns\"";
+        for (const auto& counter : result.counters) json << ",\n      \"" << escape(counter.first) << "\": " << counter.second;
+        json << "\n    }" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    json << "  ]\n}\n";
+
+    if (!console) std::fputs(json.str().c_str(), stdout);
+    if (!out.empty()) {
+        std::FILE* file = std::fopen(out.c_str(), "w");
+        bool written = file && std::fputs(json.str().c_str(), file) >= 0;
+        if (file) written = std::fclose(file) == 0 && written;
+        if (!written) {
+            std::fprintf(stderr, "Could not write %s\n", out.c_str());
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,393 @@
+// Benchmark suite for the whole project, one executable over the classes of every question
+//   CoinObjectPool (Question10), TriangleList (Question2), slow_string (Question3), Vector3 (MathLibrary, Question4),
+//   getExactHeight (Question5&6) and Catmull-Rom evaluation (Question7&8)
+// The Question*.cpp files keep their own examples and detailed comparisons. This one measures the same classes the
+// same way every time, so two runs can be compared for regressions:
+//   Benchmarks --benchmark_out=before.json   (change something, rebuild)
+//   Benchmarks --benchmark_out=after.json
+//   compare.py benchmarks before.json after.json  (tools/compare.py from Google Benchmark)
+// See BenchmarkHarness.h for the other options.
+// Allocations are tracked (AllocationTracker.h) and reported per iteration. Before the benchmarks run, the hot paths
+// that must not allocate are run once under a FrameAllocationGuard; if one allocates, its report is printed and the
+// exit code is 1.
+
+#include <cstddef>
+#include <cstdint>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#define ALLOCATION_TRACKER_HOOKS
+#include "AllocationTracker.h"
+#include "BenchmarkHarness.h"
+#include "../MathLibrary/MathLibrary.h"
+#include "../Question2/TriangleList.h"
+#include "../Question3/slow_string.h"
+#include "../Question10/CoinObjectPool.h"
+#include "../Question5&6/HeightField.h"
+#include "../Question5&6/HeightFieldBatch.h"
+#include "../Question7&8/SplinePath.h"
+#include "../Question7&8/CatmullRomSpline.h"
+#include "../Question7&8/SplineTessellation.h"
+
+// ---------------------------------------------------------------------------------------------
+// CoinObjectPool: coins dropped by enemies, some picked up, the rest expiring after 300 frames
+// ---------------------------------------------------------------------------------------------
+
+class CoinPoolFixture : public BenchmarkFixture {
+public:
+    CoinObjectPool pool;
+    std::vector<Coin*> collected;
+
+    // starts from the steady state, 30 coins per frame for 300 frames
+    void setUp(BenchmarkState&) override {
+        for (int frame = 0; frame < 300; ++frame) {
+            for (int i = 0; i < 30; ++i) pool.getCoin();
+            pool.update();
+        }
+        collected.reserve(10);
+    }
+};
+
+// one frame: 30 new coins, the player takes 5 of them, then the pool update
+BENCHMARK_F(CoinPoolFixture, churn)(BenchmarkState& state) {
+    for (auto _ : state) {
+        collected.clear();
+        for (int i = 0; i < 30; ++i) {
+            Coin* coin = pool.getCoin();
+            if (coin && i % 6 == 0) collected.push_back(coin);
+        }
+        for (Coin* coin : collected) pool.releaseCoin(coin);
+        pool.update();
+    }
+    state.setItemsProcessed(static_cast<std::int64_t>(state.iterations()) * 30);
+}
+
+// ---------------------------------------------------------------------------------------------
+// TriangleList
+// ---------------------------------------------------------------------------------------------
+
+static Triangle makeTriangle(std::size_t i) {
+    float x = static_cast<float>(i % 100), y = static_cast<float>(i / 100);
+    return Triangle(Vector3(x, y, 0), Vector3(x + 1, y, 0), Vector3(x, y + 1, 1), Color(1, 0, 0), Color(0, 1, 0), Color(0, 0, 1));
+}
+
+void triangleListBuild(BenchmarkState& state) {
+    std::size_t count = static_cast<std::size_t>(state.range(0));
+    for (auto _ : state) {
+        TriangleList list;
+        for (std::size_t i = 0; i < count; ++i) list.addTriangle(makeTriangle(i));
+        doNotOptimize(list.size());
+    }
+    state.setItemsProcessed(static_cast<std::int64_t>(state.iterations() * count));
+}
+BENCHMARK(triangleListBuild)->arg(1000)->arg(100000);
+
+void triangleListIterate(BenchmarkState& state) {
+    std::size_t count = static_cast<std::size_t>(state.range(0));
+    TriangleList list;
+    for (std::size_t i = 0; i < count; ++i) list.addTriangle(makeTriangle(i));
+    for (auto _ : state) {
+        float area = 0;
+        for (std::size_t i = 0; i < list.size(); ++i) {
+            const Triangle& triangle = list.getTriangle(i);
+            area += (triangle.vertices[1] - triangle.vertices[0]).cross(triangle.vertices[2] - triangle.vertices[0]).dot(triangle.normal);
+        }
+        doNotOptimize(area);
+    }
+    state.setItemsProcessed(static_cast<std::int64_t>(state.iterations() * count));
+}
+BENCHMARK(triangleListIterate)->arg(1000)->arg(100000);
+
+void triangleListTransform(BenchmarkState& state) {
+    std::size_t count = static_cast<std::size_t>(state.range(0));
+    TriangleList list;
+    for (std::size_t i = 0; i < count; ++i) list.addTriangle(makeTriangle(i));
+    // a rotation, so the triangles stay the same size however many times it runs
+    Matrix4x4 rotation = Quaternion::fromAxisAngle(Vector3(0, 0, 1), 0.01f).toMatrix4x4();
+    for (auto _ : state) {
+        list.transform(rotation);
+        doNotOptimize(list.getTriangle(0));
+    }
+    state.setItemsProcessed(static_cast<std::int64_t>(state.iterations() * count));
+}
+BENCHMARK(triangleListTransform)->arg(1000)->arg(100000);
+
+// ---------------------------------------------------------------------------------------------
+// slow_string
+// ---------------------------------------------------------------------------------------------
+
+// builds a string of range(0) characters from 16 character pieces
+void slowStringAppend(BenchmarkState& state) {
+    std::size_t pieces = static_cast<std::size_t>(state.range(0)) / 16;
+    slow_string piece("0123456789abcdef");
+    for (auto _ : state) {
+        slow_string text;
+        for (std::size_t i = 0; i < pieces; ++i) text += piece;
+        doNotOptimize(text.c_str());
+    }
+    state.setBytesProcessed(static_cast<std::int64_t>(state.iterations() * pieces * 16));
+}
+BENCHMARK(slowStringAppend)->arg(256)->arg(4096);
+
+static slow_string repeated(char c, std::size_t length) {
+    std::vector<char> text(length + 1, c);
+    text[length] = '\0';
+    return slow_string(text.data());
+}
+
+// equal and less-than on two strings that only differ in the last character (the slowest case for strcmp)
+void slowStringCompare(BenchmarkState& state) {
+    std::size_t length = static_cast<std::size_t>(state.range(0));
+    slow_string a = repeated('a', length), b = repeated('a', length);
+    b[length - 1] = 'b';
+    for (auto _ : state) {
+        doNotOptimize(a == b);
+        doNotOptimize(a < b);
+    }
+    state.setBytesProcessed(static_cast<std::int64_t>(state.iterations() * length * 2));
+}
+BENCHMARK(slowStringCompare)->arg(256)->arg(4096);
+
+// reads every character through operator[], which checks the index against length() (a strlen) every time
+void slowStringIndex(BenchmarkState& state) {
+    std::size_t length = static_cast<std::size_t>(state.range(0));
+    const slow_string text = repeated('x', length);
+    for (auto _ : state) {
+        int sum = 0;
+        for (std::size_t i = 0; i < length; ++i) sum += text[i];
+        doNotOptimize(sum);
+    }
+    state.setItemsProcessed(static_cast<std::int64_t>(state.iterations() * length));
+}
+BENCHMARK(slowStringIndex)->arg(256)->arg(4096);
+
+// ---------------------------------------------------------------------------------------------
+// Vector3
+// ---------------------------------------------------------------------------------------------
+
+static std::vector<Vector3> randomVectors(std::size_t count, unsigned seed) {
+    std::mt19937 random(seed);
+    std::uniform_real_distribution<float> value(-10.0f, 10.0f);
+    std::vector<Vector3> vectors;
+    vectors.reserve(count);
+    for (std::size_t i = 0; i < count; ++i) vectors.push_back(Vector3(value(random), value(random), value(random)));
+    return vectors;
+}
+
+// out = a + b * s - c, the expression chain the operators were written for
+void vector3Arithmetic(BenchmarkState& state) {
+    std::vector<Vector3> a = randomVectors(1024, 1), b = randomVectors(1024, 2), c = randomVectors(1024, 3), out(1024);
+    for (auto _ : state) {
+        for (std::size_t i = 0; i < a.size(); ++i) out[i] = a[i] + b[i] * 0.5f - c[i];
+        doNotOptimize(out.data());
+    }
+    state.setItemsProcessed(static_cast<std::int64_t>(state.iterations() * a.size()));
+}
+BENCHMARK(vector3Arithmetic);
+
+void vector3DotCross(BenchmarkState& state) {
+    std::vector<Vector3> a = randomVectors(1024, 1), b = randomVectors(1024, 2);
+    for (auto _ : state) {
+        float sum = 0;
+        for (std::size_t i = 0; i < a.size(); ++i) sum += a[i].cross(b[i]).dot(a[i]) + a[i].dot(b[i]);
+        doNotOptimize(sum);
+    }
+    state.setItemsProcessed(static_cast<std::int64_t>(state.iterations() * a.size()));
+}
+BENCHMARK(vector3DotCross);
+
+void vector3Normalize(BenchmarkState& state) {
+    std::vector<Vector3> a = randomVectors(1024, 1), out(1024);
+    for (auto _ : state) {
+        for (std::size_t i = 0; i < a.size(); ++i) out[i] = a[i].normalized();
+        doNotOptimize(out.data());
+    }
+    state.setItemsProcessed(static_cast<std::int64_t>(state.iterations() * a.size()));
+}
+BENCHMARK(vector3Normalize);
+
+// ---------------------------------------------------------------------------------------------
+// getExactHeight on a 1024x1024 height field
+// ---------------------------------------------------------------------------------------------
+
+class HeightFieldFixture : public BenchmarkFixture {
+public:
+    static constexpr std::size_t size = 1024;
+    static constexpr std::size_t queryCount = 4096;
+    HeightField<float, TiledLayout<4>> field{ size, size };
+    std::vector<float> xs, ys, heights;
+
+    void setUp(BenchmarkState&) override {
+        std::mt19937 random(5);
+        std::uniform_real_distribution<float> height(0.0f, 100.0f), coordinate(0.0f, size - 1.001f);
+        for (std::size_t x = 0; x < size; ++x)
+            for (std::size_t y = 0; y < size; ++y) field.set(x, y, height(random));
+        xs.resize(queryCount);
+        ys.resize(queryCount);
+        heights.resize(queryCount);
+        for (std::size_t i = 0; i < queryCount; ++i) {
+            xs[i] = coordinate(random);
+            ys[i] = coordinate(random);
+        }
+    }
+};
+
+BENCHMARK_F(HeightFieldFixture, getExactHeight)(BenchmarkState& state) {
+    for (auto _ : state) {
+        double sum = 0;
+        for (std::size_t i = 0; i < queryCount; ++i) sum += getExactHeight(field, xs[i], ys[i]);
+        doNotOptimize(sum);
+    }
+    state.setItemsProcessed(static_cast<std::int64_t>(state.iterations() * queryCount));
+}
+
+BENCHMARK_F(HeightFieldFixture, getExactHeights)(BenchmarkState& state) {
+    for (auto _ : state) {
+        getExactHeights(field, xs.data(), ys.data(), heights.data(), queryCount);
+        doNotOptimize(heights.data());
+    }
+    state.setItemsProcessed(static_cast<std::int64_t>(state.iterations() * queryCount));
+}
+
+// ---------------------------------------------------------------------------------------------
+// Catmull-Rom evaluation
+// ---------------------------------------------------------------------------------------------
+
+// the four point curve of Question7&8 (catmullRom(P0, P1, P2, P3, t) is SplinePath::makeSegment(...).evaluate(t))
+void catmullRomSegment(BenchmarkState& state) {
+    SplinePath::Segment segment = SplinePath::makeSegment({ 0, 0 }, { 1, 2 }, { 3, 3 }, { 4, 0 });
+    for (auto _ : state) {
+        double sum = 0;
+        for (int i = 0; i <= 1024; ++i) {
+            Point p = segment.evaluate(i / 1024.0);
+            sum += p.x + p.y;
+        }
+        doNotOptimize(sum);
+    }
+    state.setItemsProcessed(static_cast<std::int64_t>(state.iterations() * 1025));
+}
+BENCHMARK(catmullRomSegment);
+
+class SplinePathFixture : public BenchmarkFixture {
+public:
+    std::vector<Point> points;
+    std::vector<double> times;
+
+    void setUp(BenchmarkState&) override {
+        std::mt19937 random(7);
+        std::uniform_real_distribution<double> jitter(-0.25, 0.25), time(0.0, 1.0);
+        for (int i = 0; i < 1000; ++i) points.push_back({ static_cast<double>(i) + jitter(random), std::sin(i * 0.7) * 3 + jitter(random) });
+        times.resize(1024);
+        for (double& t : times) t = time(random);
+    }
+};
+
+// getPoint at random times along a uniform SplinePath through 1000 points
+BENCHMARK_F(SplinePathFixture, getPoint)(BenchmarkState& state) {
+    SplinePath path(points);
+    for (auto _ : state) {
+        double sum = 0;
+        for (double t : times) sum += path.getPoint(t).x;
+        doNotOptimize(sum);
+    }
+    state.setItemsProcessed(static_cast<std::int64_t>(state.iterations() * times.size()));
+}
+
+// the same with the centripetal CatmullRomSpline in float
+BENCHMARK_F(SplinePathFixture, centripetalGetPoint)(BenchmarkState& state) {
+    std::vector<SplineVector<2, float>> floatPoints;
+    for (const Point& p : points) floatPoints.push_back({ static_cast<float>(p.x), static_cast<float>(p.y) });
+    CatmullRomSpline<2, float> spline(floatPoints, 0.5f);
+    for (auto _ : state) {
+        float sum = 0;
+        for (double t : times) sum += spline.getPoint(static_cast<float>(t))[0];
+        doNotOptimize(sum);
+    }
+    state.setItemsProcessed(static_cast<std::int64_t>(state.iterations() * times.size()));
+}
+
+// ---------------------------------------------------------------------------------------------
+// Allocation budgets
+// ---------------------------------------------------------------------------------------------
+
+// The harness's allocs_per_iter and bytes_allocated_per_iter from this thread's allocation counts
+class AllocationMemoryManager : public BenchmarkMemoryManager {
+private:
+    AllocationStats startStats;
+
+public:
+    void start() override { startStats = AllocationTracker::getThreadStats(); }
+
+    void stop(Result& result) override {
+        AllocationStats stats = AllocationTracker::getThreadStats() - startStats;
+        result.allocations += static_cast<std::int64_t>(stats.allocations);
+        result.bytesAllocated += static_cast<std::int64_t>(stats.bytesAllocated);
+    }
+};
+
+// One frame of every per frame path that must not allocate once it is set up (or goes over its budget), throws
+// std::logic_error if one does
+static void checkFrameAllocations() {
+    // the coin pool in its steady state, 100 frames of the churn benchmark
+    CoinObjectPool pool;
+    std::vector<Coin*> collected;
+    collected.reserve(10);
+    auto coinFrame = [&] {
+        collected.clear();
+        for (int i = 0; i < 30; ++i) {
+            Coin* coin = pool.getCoin();
+            if (coin && i % 6 == 0) collected.push_back(coin);
+        }
+        for (Coin* coin : collected) pool.releaseCoin(coin);
+        pool.update();
+    };
+    for (int frame = 0; frame < 600; ++frame) coinFrame();
+    {
+        // Known offenders: the std::queue (a deque) of availableIndices gets a new 512 byte block every 128 pushes as
+        // the released and expired indices cycle through it, 23 allocations in these 100 frames. activeCoins growing
+        // its capacity adds to that until the pool settles, which is why the churn benchmark reports 0.24 - 0.27 per
+        // frame. The budget pins that rate, a pool that allocates per coin goes far over it.
+        FrameAllocationGuard guard("CoinObjectPool frames", 30);
+        for (int frame = 0; frame < 100; ++frame) coinFrame();
+        guard.check();
+    }
+
+    std::vector<Point> points;
+    for (int i = 0; i < 100; ++i) points.push_back({ static_cast<double>(i), std::sin(i * 0.7) * 3 });
+    SplinePath path(points);
+    std::vector<Point> tessellated(SplineTessellation::pathPointCount(path, 16));
+    {
+        FrameAllocationGuard guard("SplinePath sampling");
+        double sum = 0;
+        for (int i = 0; i <= 1000; ++i) sum += path.getPoint(i / 1000.0).x;
+        doNotOptimize(sum);
+        tessellatePath(path, 16, tessellated.data());
+        doNotOptimize(tessellated.data());
+        guard.check();
+    }
+
+    HeightField<float, TiledLayout<4>> field(256, 256);
+    std::vector<float> xs(256, 10.5f), ys(256, 20.25f), heights(256);
+    {
+        FrameAllocationGuard guard("getExactHeights");
+        getExactHeights(field, xs.data(), ys.data(), heights.data(), xs.size());
+        doNotOptimize(heights.data());
+        guard.check();
+    }
+}
+
+int main(int argc, char** argv)
+{
+    try {
+        checkFrameAllocations();
+    }
+    catch (const std::logic_error& error) {
+        std::fputs(error.what(), stderr);
+        return 1;
+    }
+
+    AllocationMemoryManager memory;
+    registerMemoryManager(&memory);
+    return runBenchmarks(argc, argv);
+}
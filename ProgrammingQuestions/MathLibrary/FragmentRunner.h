@@ -0,0 +1,229 @@
+// Software fragment runner: runs a ported fragment shader's main() for every pixel of an image on the CPU, so shader
+// output can be checked (golden images) on machines without a GPU
+//
+// A shader is any object with
+//   template <typename Float> glsl::tvec4<Float> operator()(const glsl::tvec4<Float>& gl_FragCoord) const
+// returning gl_FragColor (see ShaderMath.h). gl_FragCoord is the pixel centre with the origin at the bottom left
+// (x + 0.5, y + 0.5, depth 0.5, w 1), the same as GL, while the image rows are stored top row first like the files.
+// renderFragments shades 2x2 quads with Float = FloatQuad, four pixels per SSE register. The image is cut into square
+// tiles that the threads take from a shared counter, so a thread that finishes early just takes the next tile and one
+// thread never writes into another's tile. renderFragmentsScalar runs the same shader one float pixel at a time as the
+// reference. Colours are clamped to [0, 1] and rounded to 8 bits like a UNORM framebuffer.
+// runFragmentBenchmarks times both on a 4K frame and prints the results.
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ShaderMath.h"
+
+class FragmentImage {
+private:
+    int width;
+    int height;
+    std::vector<std::uint8_t> pixels;     // RGBA, row 0 at the top
+
+public:
+    FragmentImage(int width = 0, int height = 0) : width(width), height(height) {
+        if (width < 0 || height < 0) throw std::invalid_argument("The image size cannot be negative.");
+        pixels.assign(static_cast<std::size_t>(width) * height * 4, 0);
+    }
+
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+    std::uint8_t* data() { return pixels.data(); }
+    const std::uint8_t* data() const { return pixels.data(); }
+
+    // pixel (x, y) counted from the top left, 4 bytes RGBA
+    const std::uint8_t* getPixel(int x, int y) const { return &pixels[(static_cast<std::size_t>(y) * width + x) * 4]; }
+
+    // Largest difference of any channel of any pixel, or -1 if the sizes differ (what a golden image test checks)
+    int compare(const FragmentImage& other) const {
+        if (width != other.width || height != other.height) return -1;
+        int largest = 0;
+        for (std::size_t i = 0; i < pixels.size(); ++i)
+            largest = std::max(largest, std::abs(pixels[i] - other.pixels[i]));
+        return largest;
+    }
+
+    // Binary PPM (P6), alpha is dropped. Returns false if the file could not be written
+    bool writePPM(const std::string& path) const {
+        std::FILE* file = std::fopen(path.c_str(), "wb");
+        if (!file) return false;
+        std::vector<std::uint8_t> rgb(static_cast<std::size_t>(width) * height * 3);
+        for (std::size_t i = 0, j = 0; i < pixels.size(); i += 4, j += 3) {
+            rgb[j] = pixels[i];
+            rgb[j + 1] = pixels[i + 1];
+            rgb[j + 2] = pixels[i + 2];
+        }
+        bool written = std::fprintf(file, "P6\n%d %d\n255\n", width, height) > 0 && std::fwrite(rgb.data(), 1, rgb.size(), file) == rgb.size();
+        return std::fclose(file) == 0 && written;
+    }
+
+    // Reads a PPM written by writePPM (alpha set to 255), returns false if the file is missing or not a binary 8 bit PPM
+    bool readPPM(const std::string& path) {
+        std::FILE* file = std::fopen(path.c_str(), "rb");
+        if (!file) return false;
+        int fileWidth = 0, fileHeight = 0, maxValue = 0;
+        bool valid = std::fscanf(file, "P6 %d %d %d", &fileWidth, &fileHeight, &maxValue) == 3 && maxValue == 255
+                     && fileWidth >= 0 && fileHeight >= 0 && std::fgetc(file) != EOF;
+        std::vector<std::uint8_t> rgb(valid ? static_cast<std::size_t>(fileWidth) * fileHeight * 3 : 0);
+        valid = valid && std::fread(rgb.data(), 1, rgb.size(), file) == rgb.size();
+        std::fclose(file);
+        if (!valid) return false;
+
+        *this = FragmentImage(fileWidth, fileHeight);
+        for (std::size_t i = 0, j = 0; j < rgb.size(); i += 4, j += 3) {
+            pixels[i] = rgb[j];
+            pixels[i + 1] = rgb[j + 1];
+            pixels[i + 2] = rgb[j + 2];
+            pixels[i + 3] = 255;
+        }
+        return true;
+    }
+};
+
+// [0, 1] to a byte, the way a UNORM8 render target stores a colour
+inline std::uint8_t toUnorm8(float value) {
+    value = value < 0.0f ? 0.0f : value > 1.0f ? 1.0f : value;     // also turns NaN into 0
+    return static_cast<std::uint8_t>(value * 255.0f + 0.5f);
+}
+
+// Writes a shaded quad: lanes 0 and 1 to the two pixels at row0, lanes 2 and 3 to the two pixels at row1
+inline void storeQuad(const glsl::tvec4<glsl::FloatQuad>& color, std::uint8_t* row0, std::uint8_t* row1) {
+#ifdef SHADER_USE_SSE2
+    // clamp, scale and round all 16 channels at once, transposed from one register per channel to one per pixel and
+    // packed down to bytes. The max comes first so a NaN becomes 0 like in toUnorm8
+    const __m128 zero = _mm_setzero_ps(), one = _mm_set1_ps(1.0f), scale = _mm_set1_ps(255.0f), half = _mm_set1_ps(0.5f);
+    __m128 channels[4] = { color.x.data, color.y.data, color.z.data, color.w.data };
+    for (__m128& channel : channels)
+        channel = _mm_add_ps(_mm_mul_ps(_mm_min_ps(_mm_max_ps(channel, zero), one), scale), half);
+    _MM_TRANSPOSE4_PS(channels[0], channels[1], channels[2], channels[3]);
+    __m128i low = _mm_packs_epi32(_mm_cvttps_epi32(channels[0]), _mm_cvttps_epi32(channels[1]));
+    __m128i high = _mm_packs_epi32(_mm_cvttps_epi32(channels[2]), _mm_cvttps_epi32(channels[3]));
+    __m128i bytes = _mm_packus_epi16(low, high);
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(row0), bytes);
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(row1), _mm_unpackhi_epi64(bytes, bytes));
+#else
+    float r[4], g[4], b[4], a[4];
+    color.x.store(r); color.y.store(g); color.z.store(b); color.w.store(a);
+    for (int lane = 0; lane < 4; ++lane) {
+        std::uint8_t* pixel = (lane < 2 ? row0 : row1) + (lane & 1) * 4;
+        pixel[0] = toUnorm8(r[lane]);
+        pixel[1] = toUnorm8(g[lane]);
+        pixel[2] = toUnorm8(b[lane]);
+        pixel[3] = toUnorm8(a[lane]);
+    }
+#endif
+}
+
+// Shades every pixel with the shader, one 2x2 quad per call. threadCount 0 uses every hardware thread
+template <typename Shader>
+void renderFragments(const Shader& shader, FragmentImage& image, unsigned threadCount = 0, int tileSize = 64) {
+    using glsl::FloatQuad;
+    const int width = image.getWidth(), height = image.getHeight();
+    if (width == 0 || height == 0) return;
+    tileSize = std::max(2, tileSize & ~1);      // tiles start on even pixels, so quads never straddle two tiles
+    const int tilesX = (width + tileSize - 1) / tileSize, tilesY = (height + tileSize - 1) / tileSize;
+    const int tileCount = tilesX * tilesY;
+    std::uint8_t* pixels = image.data();
+    std::atomic<int> nextTile(0);
+
+    auto work = [&]() {
+        float r[4], g[4], b[4], a[4];
+        for (int tile = nextTile++; tile < tileCount; tile = nextTile++) {
+            int left = tile % tilesX * tileSize, top = tile / tilesX * tileSize;
+            int right = std::min(left + tileSize, width), bottom = std::min(top + tileSize, height);
+            for (int y = top; y < bottom; y += 2) {
+                // lanes: (x, y), (x + 1, y), (x, y + 1), (x + 1, y + 1), with y flipped to GL's bottom up rows
+                float upper = static_cast<float>(height - y) - 0.5f;
+                FloatQuad fragY(upper, upper, upper - 1.0f, upper - 1.0f);
+                for (int x = left; x < right; x += 2) {
+                    float column = static_cast<float>(x) + 0.5f;
+                    glsl::tvec4<FloatQuad> fragCoord(FloatQuad(column, column + 1.0f, column, column + 1.0f), fragY, 0.5f, 1.0f);
+                    glsl::tvec4<FloatQuad> color = shader(fragCoord);
+                    std::uint8_t* row0 = pixels + (static_cast<std::size_t>(y) * width + x) * 4;
+                    if (x + 1 < width && y + 1 < height) {
+                        storeQuad(color, row0, row0 + static_cast<std::size_t>(width) * 4);
+                        continue;
+                    }
+
+                    // the second column / row of a quad is off the image when the size is odd
+                    color.x.store(r); color.y.store(g); color.z.store(b); color.w.store(a);
+                    for (int lane = 0; lane < 4; ++lane) {
+                        int px = x + (lane & 1), py = y + (lane >> 1);
+                        if (px >= width || py >= height) continue;
+                        std::uint8_t* pixel = pixels + (static_cast<std::size_t>(py) * width + px) * 4;
+                        pixel[0] = toUnorm8(r[lane]);
+                        pixel[1] = toUnorm8(g[lane]);
+                        pixel[2] = toUnorm8(b[lane]);
+                        pixel[3] = toUnorm8(a[lane]);
+                    }
+                }
+            }
+        }
+    };
+
+    if (threadCount == 0) threadCount = std::max(1u, std::thread::hardware_concurrency());
+    threadCount = static_cast<unsigned>(std::min(threadCount, static_cast<unsigned>(tileCount)));
+    std::vector<std::thread> threads;
+    threads.reserve(threadCount - 1);
+    for (unsigned i = 1; i < threadCount; ++i) threads.emplace_back(work);
+    work();
+    for (std::thread& thread : threads) thread.join();
+}
+
+// Reference: the same shader one pixel at a time in plain float, on the calling thread
+template <typename Shader>
+void renderFragmentsScalar(const Shader& shader, FragmentImage& image) {
+    const int width = image.getWidth(), height = image.getHeight();
+    std::uint8_t* pixel = image.data();
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x, pixel += 4) {
+            glsl::vec4 fragCoord(static_cast<float>(x) + 0.5f, static_cast<float>(height - y) - 0.5f, 0.5f, 1.0f);
+            glsl::vec4 color = shader(fragCoord);
+            pixel[0] = toUnorm8(color.x);
+            pixel[1] = toUnorm8(color.y);
+            pixel[2] = toUnorm8(color.z);
+            pixel[3] = toUnorm8(color.w);
+        }
+    }
+}
+
+// Renders a 4K frame with the reference, the quads on one thread and the quads on every thread, best of 5 runs each
+template <typename Shader>
+void runFragmentBenchmarks(const Shader& shader) {
+    FragmentImage reference(3840, 2160), quads(3840, 2160), threaded(3840, 2160);
+    renderFragments(shader, threaded);      // warm up (page in the images, start the threads once)
+
+    auto best = [](auto&& render) {
+        double fastest = 0;
+        for (int run = 0; run < 5; ++run) {
+            auto start = std::chrono::high_resolution_clock::now();
+            render();
+            double ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+            fastest = run == 0 ? ms : std::min(fastest, ms);
+        }
+        return fastest;
+    };
+    double scalar = best([&] { renderFragmentsScalar(shader, reference); });
+    double quad = best([&] { renderFragments(shader, quads, 1); });
+    double parallel = best([&] { renderFragments(shader, threaded); });
+
+    std::cout << std::endl << "3840x2160 frame" << std::endl;
+    std::cout << "  one pixel at a time:           " << scalar << " ms" << std::endl;
+    std::cout << "  2x2 quads, 1 thread:           " << quad << " ms" << std::endl;
+    std::cout << "  2x2 quads, " << std::max(1u, std::thread::hardware_concurrency()) << " hardware threads: " << parallel << " ms" << std::endl;
+    std::cout << "  largest difference from the reference: " << quads.compare(reference) << " / " << threaded.compare(reference) << std::endl;
+}
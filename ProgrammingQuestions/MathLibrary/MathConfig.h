@@ -0,0 +1,37 @@
+// Shared configuration for the header-only math library (Vector2/3/4, Matrix3x3/4x4, Quaternion, Vector3Array)
+// Every type is backed by SSE registers whenever the target supports it,
+// compile with MATH_NO_SIMD defined (e.g. -DMATH_NO_SIMD) to switch the whole library back to plain scalar code
+
+#pragma once
+
+#if !defined(MATH_NO_SIMD) && (defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1))
+#define MATH_USE_SIMD 1
+#include <xmmintrin.h>
+#endif
+
+// the batch kernels (Vector3Array, transformPoints) use 8-wide AVX when the compiler is allowed to emit AVX2 (e.g. -mavx2 or /arch:AVX2)
+// and fall back to plain scalar loops otherwise, MATH_NO_SIMD disables them as well
+#if !defined(MATH_NO_SIMD) && defined(__AVX2__)
+#define MATH_USE_AVX2 1
+#include <immintrin.h>
+#endif
+
+// Functions that can be evaluated at compile time in the scalar build (SSE intrinsics are not constexpr)
+#ifdef MATH_USE_SIMD
+#define MATH_CONSTEXPR inline
+#else
+#define MATH_CONSTEXPR constexpr
+#endif
+
+#ifdef MATH_USE_SIMD
+// Adds up all four lanes of v and returns the sum broadcast into every lane
+// only shuffles and adds are used so this works on plain SSE (no SSE3 hadd / SSE4.1 dp needed)
+inline __m128 horizontalSum(__m128 v)
+{
+    __m128 swapped = _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1)); // (y, x, w, z)
+    __m128 pairs = _mm_add_ps(v, swapped);                          // (x+y, x+y, z+w, z+w)
+    swapped = _mm_movehl_ps(swapped, pairs);                        // (z+w, z+w, ...)
+    __m128 sum = _mm_add_ss(pairs, swapped);                        // x+y+z+w in lane 0
+    return _mm_shuffle_ps(sum, sum, _MM_SHUFFLE(0, 0, 0, 0));
+}
+#endif
\ No newline at end of file
@@ -0,0 +1,21 @@
+// Header-only math library shared by the questions
+// Include this to get every type, or include the individual headers:
+//   Vector2.h, Vector3.h, Vector4.h  - vectors (Vector3 uses expression templates, see Vector3.h)
+//   Matrix3x3.h, Matrix4x4.h         - column-major matrices for column vectors (v' = M * v)
+//   Quaternion.h                     - rotations and slerp
+//   Vector3Array.h                   - structure of arrays storage and AVX2 batch kernels
+// Not included here, for running ported fragment shaders on the CPU:
+//   ShaderMath.h                     - GLSL style float / 2x2 pixel quad math (namespace glsl)
+//   FragmentRunner.h                 - tiled, multithreaded fragment runner and images for golden image checks
+// Define MATH_NO_SIMD to build everything with plain scalar code (see MathConfig.h)
+
+#pragma once
+
+#include "MathConfig.h"
+#include "Vector2.h"
+#include "Vector3.h"
+#include "Vector4.h"
+#include "Matrix3x3.h"
+#include "Matrix4x4.h"
+#include "Quaternion.h"
+#include "Vector3Array.h"
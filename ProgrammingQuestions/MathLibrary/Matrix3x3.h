@@ -0,0 +1,89 @@
+// 3x3 matrix for rotations / scales / normal transforms
+// Stored as three Vector3 columns and used with column vectors (v' = M * v), so every operation below is written in
+// terms of Vector3 operations and inherits their SSE implementation.
+
+#pragma once
+
+#include <iostream>
+#include <stdexcept>
+
+#include "MathConfig.h"
+#include "Vector3.h"
+
+class Matrix3x3 {
+private:
+    Vector3 columns[3];
+
+    static float component(const Vector3& v, int i) {
+        return i == 0 ? v.getX() : (i == 1 ? v.getY() : v.getZ());
+    }
+
+public:
+    // default constructor creates the identity matrix
+    Matrix3x3() : columns{ Vector3(1, 0, 0), Vector3(0, 1, 0), Vector3(0, 0, 1) } {}
+
+    // build a matrix from its three columns (i.e. the images of the x, y and z axes)
+    Matrix3x3(const Vector3& c0, const Vector3& c1, const Vector3& c2) : columns{ c0, c1, c2 } {}
+
+    static Matrix3x3 identity() {
+        return Matrix3x3();
+    }
+
+    static Matrix3x3 scale(const Vector3& s) {
+        return Matrix3x3(Vector3(s.getX(), 0, 0), Vector3(0, s.getY(), 0), Vector3(0, 0, s.getZ()));
+    }
+
+    // Column and element access (read only)
+    const Vector3& getColumn(int index) const {
+        if (index < 0 || index > 2) throw std::out_of_range("Index is out of range!");
+        return columns[index];
+    }
+
+    float operator()(int row, int col) const {
+        return component(getColumn(col), row);
+    }
+
+    // Transform a vector: a weighted sum of the columns
+    Vector3 operator*(const Vector3& v) const {
+        return columns[0] * v.getX() + columns[1] * v.getY() + columns[2] * v.getZ();
+    }
+
+    // Matrix product, (A * B) * v == A * (B * v)
+    Matrix3x3 operator*(const Matrix3x3& other) const {
+        return Matrix3x3(*this * other.columns[0], *this * other.columns[1], *this * other.columns[2]);
+    }
+
+    Matrix3x3 transposed() const {
+        return Matrix3x3(
+            Vector3(columns[0].getX(), columns[1].getX(), columns[2].getX()),
+            Vector3(columns[0].getY(), columns[1].getY(), columns[2].getY()),
+            Vector3(columns[0].getZ(), columns[1].getZ(), columns[2].getZ()));
+    }
+
+    // Determinant as the scalar triple product of the columns
+    float determinant() const {
+        return columns[0].dot(columns[1].cross(columns[2]));
+    }
+
+    // Inverse (throws on a singular matrix, same as division by zero)
+    // the rows of the inverse are the cross products of pairs of columns divided by the determinant
+    Matrix3x3 inverse() const {
+        Vector3 r0 = columns[1].cross(columns[2]);
+        Vector3 r1 = columns[2].cross(columns[0]);
+        Vector3 r2 = columns[0].cross(columns[1]);
+        float det = columns[0].dot(r0);
+        if (det == 0) throw std::runtime_error("Matrix is not invertible");
+        float invDet = 1.0f / det;
+        return Matrix3x3(r0 * invDet, r1 * invDet, r2 * invDet).transposed();
+    }
+
+    // print to console, one row per line
+    void print() const {
+        for (int row = 0; row < 3; ++row) {
+            std::cout << "| ";
+            for (int col = 0; col < 3; ++col)
+                std::cout << (*this)(row, col) << " ";
+            std::cout << "|" << std::endl;
+        }
+    }
+};
@@ -0,0 +1,171 @@
+// 4x4 matrix for affine / projective transforms
+// Stored as four Vector4 columns and used with column vectors (p' = M * p). A column is one SSE register, so
+// matrix * vector is four broadcast multiply-adds and matrix * matrix is four of those.
+
+#pragma once
+
+#include <iostream>
+#include <cstddef>
+#include <stdexcept>
+
+#include "MathConfig.h"
+#include "Vector3.h"
+#include "Vector4.h"
+#include "Matrix3x3.h"
+
+class Matrix4x4 {
+private:
+    Vector4 columns[4];
+
+    static float component(const Vector4& v, int i) {
+        switch (i) {
+        case 0: return v.getX();
+        case 1: return v.getY();
+        case 2: return v.getZ();
+        default: return v.getW();
+        }
+    }
+
+public:
+    // default constructor creates the identity matrix
+    Matrix4x4() : columns{ Vector4(1, 0, 0, 0), Vector4(0, 1, 0, 0), Vector4(0, 0, 1, 0), Vector4(0, 0, 0, 1) } {}
+
+    // build a matrix from its four columns
+    Matrix4x4(const Vector4& c0, const Vector4& c1, const Vector4& c2, const Vector4& c3) : columns{ c0, c1, c2, c3 } {}
+
+    // affine transform: apply linear, then translate
+    Matrix4x4(const Matrix3x3& linear, const Vector3& translation)
+        : columns{ Vector4(linear.getColumn(0), 0), Vector4(linear.getColumn(1), 0), Vector4(linear.getColumn(2), 0), Vector4(translation, 1) } {}
+
+    static Matrix4x4 identity() {
+        return Matrix4x4();
+    }
+
+    static Matrix4x4 translation(const Vector3& t) {
+        return Matrix4x4(Matrix3x3(), t);
+    }
+
+    static Matrix4x4 scale(const Vector3& s) {
+        return Matrix4x4(Matrix3x3::scale(s), Vector3());
+    }
+
+    // Column and element access (read only)
+    const Vector4& getColumn(int index) const {
+        if (index < 0 || index > 3) throw std::out_of_range("Index is out of range!");
+        return columns[index];
+    }
+
+    float operator()(int row, int col) const {
+        return component(getColumn(col), row);
+    }
+
+    // the upper left 3x3 block (rotation and scale part of an affine transform)
+    Matrix3x3 linearPart() const {
+        return Matrix3x3(columns[0].xyz(), columns[1].xyz(), columns[2].xyz());
+    }
+
+    // Transform a homogeneous vector: a weighted sum of the columns
+    Vector4 operator*(const Vector4& v) const {
+        return columns[0] * v.getX() + columns[1] * v.getY() + columns[2] * v.getZ() + columns[3] * v.getW();
+    }
+
+    // Matrix product, (A * B) * v == A * (B * v)
+    Matrix4x4 operator*(const Matrix4x4& other) const {
+        return Matrix4x4(*this * other.columns[0], *this * other.columns[1], *this * other.columns[2], *this * other.columns[3]);
+    }
+
+    // Transform a point (w = 1, so translation applies). Assumes an affine matrix, i.e. the result is not divided by w
+    Vector3 transformPoint(const Vector3& p) const {
+        return (columns[0] * p.getX() + columns[1] * p.getY() + columns[2] * p.getZ() + columns[3]).xyz();
+    }
+
+    // Transform a direction (w = 0, so translation is ignored)
+    Vector3 transformVector(const Vector3& v) const {
+        return (columns[0] * v.getX() + columns[1] * v.getY() + columns[2] * v.getZ()).xyz();
+    }
+
+    // Transform count points from in to out (in and out may be the same array)
+    // the columns stay in registers for the whole loop, for very large point sets see Vector3Batch::transform
+    void transformPoints(const Vector3* in, Vector3* out, std::size_t count) const {
+        const Vector4 c0 = columns[0], c1 = columns[1], c2 = columns[2], c3 = columns[3];
+        for (std::size_t i = 0; i < count; ++i) {
+            const Vector3& p = in[i];
+            out[i] = (c0 * p.getX() + c1 * p.getY() + c2 * p.getZ() + c3).xyz();
+        }
+    }
+
+    Matrix4x4 transposed() const {
+        const Matrix4x4& m = *this;
+        return Matrix4x4(
+            Vector4(m(0, 0), m(0, 1), m(0, 2), m(0, 3)),
+            Vector4(m(1, 0), m(1, 1), m(1, 2), m(1, 3)),
+            Vector4(m(2, 0), m(2, 1), m(2, 2), m(2, 3)),
+            Vector4(m(3, 0), m(3, 1), m(3, 2), m(3, 3)));
+    }
+
+    // General inverse (throws on a singular matrix, same as division by zero)
+    // uses the 2x2 sub-determinant (Laplace expansion) form, which shares the 12 2x2 determinants between all cofactors
+    Matrix4x4 inverse() const {
+        float a[4][4];
+        for (int r = 0; r < 4; ++r)
+            for (int c = 0; c < 4; ++c)
+                a[r][c] = (*this)(r, c);
+
+        float s0 = a[0][0] * a[1][1] - a[1][0] * a[0][1];
+        float s1 = a[0][0] * a[1][2] - a[1][0] * a[0][2];
+        float s2 = a[0][0] * a[1][3] - a[1][0] * a[0][3];
+        float s3 = a[0][1] * a[1][2] - a[1][1] * a[0][2];
+        float s4 = a[0][1] * a[1][3] - a[1][1] * a[0][3];
+        float s5 = a[0][2] * a[1][3] - a[1][2] * a[0][3];
+
+        float c5 = a[2][2] * a[3][3] - a[3][2] * a[2][3];
+        float c4 = a[2][1] * a[3][3] - a[3][1] * a[2][3];
+        float c3 = a[2][1] * a[3][2] - a[3][1] * a[2][2];
+        float c2 = a[2][0] * a[3][3] - a[3][0] * a[2][3];
+        float c1 = a[2][0] * a[3][2] - a[3][0] * a[2][2];
+        float c0 = a[2][0] * a[3][1] - a[3][0] * a[2][1];
+
+        float det = s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0;
+        if (det == 0) throw std::runtime_error("Matrix is not invertible");
+        float invDet = 1.0f / det;
+
+        // b[r][c] of the inverse, written out column by column
+        return Matrix4x4(
+            Vector4(
+                (a[1][1] * c5 - a[1][2] * c4 + a[1][3] * c3),
+                (-a[1][0] * c5 + a[1][2] * c2 - a[1][3] * c1),
+                (a[1][0] * c4 - a[1][1] * c2 + a[1][3] * c0),
+                (-a[1][0] * c3 + a[1][1] * c1 - a[1][2] * c0)) * invDet,
+            Vector4(
+                (-a[0][1] * c5 + a[0][2] * c4 - a[0][3] * c3),
+                (a[0][0] * c5 - a[0][2] * c2 + a[0][3] * c1),
+                (-a[0][0] * c4 + a[0][1] * c2 - a[0][3] * c0),
+                (a[0][0] * c3 - a[0][1] * c1 + a[0][2] * c0)) * invDet,
+            Vector4(
+                (a[3][1] * s5 - a[3][2] * s4 + a[3][3] * s3),
+                (-a[3][0] * s5 + a[3][2] * s2 - a[3][3] * s1),
+                (a[3][0] * s4 - a[3][1] * s2 + a[3][3] * s0),
+                (-a[3][0] * s3 + a[3][1] * s1 - a[3][2] * s0)) * invDet,
+            Vector4(
+                (-a[2][1] * s5 + a[2][2] * s4 - a[2][3] * s3),
+                (a[2][0] * s5 - a[2][2] * s2 + a[2][3] * s1),
+                (-a[2][0] * s4 + a[2][1] * s2 - a[2][3] * s0),
+                (a[2][0] * s3 - a[2][1] * s1 + a[2][2] * s0)) * invDet);
+    }
+
+    // Cheaper inverse for affine matrices (bottom row 0 0 0 1): invert the 3x3 part and un-apply the translation
+    Matrix4x4 inverseAffine() const {
+        Matrix3x3 linearInverse = linearPart().inverse();
+        return Matrix4x4(linearInverse, (linearInverse * columns[3].xyz()) * -1.0f);
+    }
+
+    // print to console, one row per line
+    void print() const {
+        for (int row = 0; row < 4; ++row) {
+            std::cout << "| ";
+            for (int col = 0; col < 4; ++col)
+                std::cout << (*this)(row, col) << " ";
+            std::cout << "|" << std::endl;
+        }
+    }
+};
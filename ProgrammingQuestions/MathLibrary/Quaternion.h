@@ -0,0 +1,117 @@
+// Unit quaternion for rotations
+// Stored as a Vector4 (x, y, z = imaginary part, w = real part), so dot products, scaling, blending and
+// normalization all run on the Vector4 SSE path.
+
+#pragma once
+
+#include <iostream>
+#include <cmath>
+
+#include "MathConfig.h"
+#include "Vector3.h"
+#include "Vector4.h"
+#include "Matrix3x3.h"
+#include "Matrix4x4.h"
+
+class Quaternion {
+private:
+    Vector4 q;
+
+    explicit Quaternion(const Vector4& q) : q(q) {}
+
+public:
+    // default constructor creates the identity rotation
+    Quaternion(float x = 0.0f, float y = 0.0f, float z = 0.0f, float w = 1.0f) : q(x, y, z, w) {}
+
+    static Quaternion identity() {
+        return Quaternion();
+    }
+
+    // rotation of angle radians (counter-clockwise) around axis, the axis does not need to be normalized
+    static Quaternion fromAxisAngle(const Vector3& axis, float angle) {
+        float halfAngle = angle * 0.5f;
+        return Quaternion(Vector4(axis.normalized() * std::sin(halfAngle), std::cos(halfAngle)));
+    }
+
+    // Hamilton product, (a * b) rotates by b first and then by a
+    Quaternion operator*(const Quaternion& other) const {
+        float x1 = q.getX(), y1 = q.getY(), z1 = q.getZ(), w1 = q.getW();
+        float x2 = other.q.getX(), y2 = other.q.getY(), z2 = other.q.getZ(), w2 = other.q.getW();
+        return Quaternion(
+            w1 * x2 + x1 * w2 + y1 * z2 - z1 * y2,
+            w1 * y2 - x1 * z2 + y1 * w2 + z1 * x2,
+            w1 * z2 + x1 * y2 - y1 * x2 + z1 * w2,
+            w1 * w2 - x1 * x2 - y1 * y2 - z1 * z2);
+    }
+
+    float dot(const Quaternion& other) const {
+        return q.dot(other.q);
+    }
+
+    float length() const {
+        return q.length();
+    }
+
+    // Returns a unit length copy (throws on a zero quaternion, same as division)
+    Quaternion normalized() const {
+        return Quaternion(q.normalized());
+    }
+
+    // the inverse rotation for a unit quaternion
+    Quaternion conjugate() const {
+        return Quaternion(-q.getX(), -q.getY(), -q.getZ(), q.getW());
+    }
+
+    // Rotate a vector, using v' = v + w * t + u x t with t = 2 * (u x v), which is two cross products
+    // instead of the full q * v * q^-1 sandwich
+    Vector3 rotate(const Vector3& v) const {
+        Vector3 u = q.xyz();
+        Vector3 t = u.cross(v) * 2.0f;
+        return v + t * q.getW() + u.cross(t);
+    }
+
+    // Spherical linear interpolation between two unit quaternions, always along the shorter arc
+    // falls back to a normalized lerp when the rotations are almost identical (sin(theta) ~ 0)
+    static Quaternion slerp(const Quaternion& a, const Quaternion& b, float t) {
+        float cosTheta = a.dot(b);
+        Vector4 end = b.q;
+        if (cosTheta < 0) {
+            cosTheta = -cosTheta;
+            end = end * -1.0f;
+        }
+
+        if (cosTheta > 0.9995f) {
+            return Quaternion((a.q + (end - a.q) * t).normalized());
+        }
+
+        float theta = std::acos(cosTheta);
+        float invSinTheta = 1.0f / std::sin(theta);
+        float wa = std::sin((1 - t) * theta) * invSinTheta;
+        float wb = std::sin(t * theta) * invSinTheta;
+        return Quaternion(a.q * wa + end * wb);
+    }
+
+    // Rotation matrix equivalent to this (unit) quaternion
+    Matrix3x3 toMatrix3x3() const {
+        float x = q.getX(), y = q.getY(), z = q.getZ(), w = q.getW();
+        return Matrix3x3(
+            Vector3(1 - 2 * (y * y + z * z), 2 * (x * y + z * w), 2 * (x * z - y * w)),
+            Vector3(2 * (x * y - z * w), 1 - 2 * (x * x + z * z), 2 * (y * z + x * w)),
+            Vector3(2 * (x * z + y * w), 2 * (y * z - x * w), 1 - 2 * (x * x + y * y)));
+    }
+
+    Matrix4x4 toMatrix4x4() const {
+        return Matrix4x4(toMatrix3x3(), Vector3());
+    }
+
+    // Component accessors (read only, the data itself stays private)
+    float getX() const { return q.getX(); }
+    float getY() const { return q.getY(); }
+    float getZ() const { return q.getZ(); }
+    float getW() const { return q.getW(); }
+
+    // print to console the provided quaternion
+    void print() const {
+        q.print();
+    }
+};
@@ -0,0 +1,215 @@
+// GLSL style math for running fragment shaders on the CPU (see FragmentRunner.h)
+// A shader is ported once, as a template on its float type:
+//   float      - one pixel at a time, the reference that reads exactly like the GLSL
+//   FloatQuad  - a 2x2 quad of pixels in the four lanes of one SSE register, the way a GPU shades them
+// Comparisons on a FloatQuad give a QuadMask instead of a bool, so branches in the GLSL become select(condition, a, b),
+// which has an overload for bool too and keeps one source for both. The builtins follow the GLSL definitions
+// (mod(x, y) = x - y * floor(x / y), mix(a, b, t) = a * (1 - t) + b * t) with the operations in the same order for
+// both types, so a quad and four single pixels give bit identical results.
+// With MATH_NO_SIMD (or without SSE2) FloatQuad is a plain array of four floats.
+
+#pragma once
+
+#include <cmath>
+#include <algorithm>
+
+#include "MathConfig.h"
+
+#if defined(MATH_USE_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define SHADER_USE_SSE2 1
+#include <emmintrin.h>
+#ifdef __SSE4_1__
+#include <smmintrin.h>
+#endif
+#endif
+
+namespace glsl {
+
+// Per lane true / false from comparing two FloatQuads
+class QuadMask {
+public:
+#ifdef SHADER_USE_SSE2
+    __m128 data;        // all bits set in a true lane
+    explicit QuadMask(__m128 data) : data(data) {}
+
+    QuadMask operator&&(const QuadMask& other) const { return QuadMask(_mm_and_ps(data, other.data)); }
+    QuadMask operator||(const QuadMask& other) const { return QuadMask(_mm_or_ps(data, other.data)); }
+    bool any() const { return _mm_movemask_ps(data) != 0; }
+    bool all() const { return _mm_movemask_ps(data) == 0xF; }
+#else
+    bool lanes[4];
+
+    QuadMask operator&&(const QuadMask& other) const {
+        QuadMask result;
+        for (int i = 0; i < 4; ++i) result.lanes[i] = lanes[i] && other.lanes[i];
+        return result;
+    }
+    QuadMask operator||(const QuadMask& other) const {
+        QuadMask result;
+        for (int i = 0; i < 4; ++i) result.lanes[i] = lanes[i] || other.lanes[i];
+        return result;
+    }
+    bool any() const { return lanes[0] || lanes[1] || lanes[2] || lanes[3]; }
+    bool all() const { return lanes[0] && lanes[1] && lanes[2] && lanes[3]; }
+#endif
+};
+
+// Four floats, one per pixel of a 2x2 quad, with the arithmetic of a GLSL float
+class alignas(16) FloatQuad {
+public:
+#ifdef SHADER_USE_SSE2
+    __m128 data;
+    explicit FloatQuad(__m128 data) : data(data) {}
+
+    // every lane set to value, so literals in the shader (2.0 * x) work unchanged
+    FloatQuad(float value = 0.0f) : data(_mm_set1_ps(value)) {}
+    FloatQuad(float a, float b, float c, float d) : data(_mm_set_ps(d, c, b, a)) {}
+
+    void store(float* out) const { _mm_storeu_ps(out, data); }
+
+    FloatQuad operator-() const { return FloatQuad(_mm_xor_ps(data, _mm_set1_ps(-0.0f))); }
+    friend FloatQuad operator+(const FloatQuad& a, const FloatQuad& b) { return FloatQuad(_mm_add_ps(a.data, b.data)); }
+    friend FloatQuad operator-(const FloatQuad& a, const FloatQuad& b) { return FloatQuad(_mm_sub_ps(a.data, b.data)); }
+    friend FloatQuad operator*(const FloatQuad& a, const FloatQuad& b) { return FloatQuad(_mm_mul_ps(a.data, b.data)); }
+    friend FloatQuad operator/(const FloatQuad& a, const FloatQuad& b) { return FloatQuad(_mm_div_ps(a.data, b.data)); }
+
+    friend QuadMask operator<(const FloatQuad& a, const FloatQuad& b) { return QuadMask(_mm_cmplt_ps(a.data, b.data)); }
+    friend QuadMask operator<=(const FloatQuad& a, const FloatQuad& b) { return QuadMask(_mm_cmple_ps(a.data, b.data)); }
+    friend QuadMask operator>(const FloatQuad& a, const FloatQuad& b) { return QuadMask(_mm_cmpgt_ps(a.data, b.data)); }
+    friend QuadMask operator>=(const FloatQuad& a, const FloatQuad& b) { return QuadMask(_mm_cmpge_ps(a.data, b.data)); }
+#else
+    float lanes[4];
+
+    FloatQuad(float value = 0.0f) : lanes{ value, value, value, value } {}
+    FloatQuad(float a, float b, float c, float d) : lanes{ a, b, c, d } {}
+
+    void store(float* out) const { for (int i = 0; i < 4; ++i) out[i] = lanes[i]; }
+
+    FloatQuad operator-() const { return FloatQuad(-lanes[0], -lanes[1], -lanes[2], -lanes[3]); }
+    friend FloatQuad operator+(const FloatQuad& a, const FloatQuad& b) { return a.apply(b, [](float x, float y) { return x + y; }); }
+    friend FloatQuad operator-(const FloatQuad& a, const FloatQuad& b) { return a.apply(b, [](float x, float y) { return x - y; }); }
+    friend FloatQuad operator*(const FloatQuad& a, const FloatQuad& b) { return a.apply(b, [](float x, float y) { return x * y; }); }
+    friend FloatQuad operator/(const FloatQuad& a, const FloatQuad& b) { return a.apply(b, [](float x, float y) { return x / y; }); }
+
+    friend QuadMask operator<(const FloatQuad& a, const FloatQuad& b) { return a.compare(b, [](float x, float y) { return x < y; }); }
+    friend QuadMask operator<=(const FloatQuad& a, const FloatQuad& b) { return a.compare(b, [](float x, float y) { return x <= y; }); }
+    friend QuadMask operator>(const FloatQuad& a, const FloatQuad& b) { return a.compare(b, [](float x, float y) { return x > y; }); }
+    friend QuadMask operator>=(const FloatQuad& a, const FloatQuad& b) { return a.compare(b, [](float x, float y) { return x >= y; }); }
+
+    template <typename Operation>
+    FloatQuad apply(const FloatQuad& other, Operation operation) const {
+        return FloatQuad(operation(lanes[0], other.lanes[0]), operation(lanes[1], other.lanes[1]),
+                         operation(lanes[2], other.lanes[2]), operation(lanes[3], other.lanes[3]));
+    }
+
+    template <typename Operation>
+    QuadMask compare(const FloatQuad& other, Operation operation) const {
+        QuadMask mask;
+        for (int i = 0; i < 4; ++i) mask.lanes[i] = operation(lanes[i], other.lanes[i]);
+        return mask;
+    }
+#endif
+
+    FloatQuad& operator+=(const FloatQuad& other) { return *this = *this + other; }
+    FloatQuad& operator-=(const FloatQuad& other) { return *this = *this - other; }
+    FloatQuad& operator*=(const FloatQuad& other) { return *this = *this * other; }
+    FloatQuad& operator/=(const FloatQuad& other) { return *this = *this / other; }
+};
+
+// condition ? a : b, per lane for a quad
+inline float select(bool condition, float a, float b) { return condition ? a : b; }
+
+inline FloatQuad select(const QuadMask& condition, const FloatQuad& a, const FloatQuad& b) {
+#ifdef SHADER_USE_SSE2
+    return FloatQuad(_mm_or_ps(_mm_and_ps(condition.data, a.data), _mm_andnot_ps(condition.data, b.data)));
+#else
+    return FloatQuad(condition.lanes[0] ? a.lanes[0] : b.lanes[0], condition.lanes[1] ? a.lanes[1] : b.lanes[1],
+                     condition.lanes[2] ? a.lanes[2] : b.lanes[2], condition.lanes[3] ? a.lanes[3] : b.lanes[3]);
+#endif
+}
+
+// Builtins, float versions first
+
+inline float abs(float x) { return std::fabs(x); }
+inline float floor(float x) { return std::floor(x); }
+inline float min(float a, float b) { return b < a ? b : a; }
+inline float max(float a, float b) { return a < b ? b : a; }
+
+inline FloatQuad abs(const FloatQuad& x) {
+#ifdef SHADER_USE_SSE2
+    return FloatQuad(_mm_andnot_ps(_mm_set1_ps(-0.0f), x.data));
+#else
+    return FloatQuad(std::fabs(x.lanes[0]), std::fabs(x.lanes[1]), std::fabs(x.lanes[2]), std::fabs(x.lanes[3]));
+#endif
+}
+
+inline FloatQuad floor(const FloatQuad& x) {
+#if defined(SHADER_USE_SSE2) && defined(__SSE4_1__)
+    return FloatQuad(_mm_floor_ps(x.data));
+#elif defined(SHADER_USE_SSE2)
+    // truncate, then step down where that rounded a negative value up, and put the sign of x back (the conversion loses
+    // it for -0 and for (-1, 0), which floor to -0 and -1). Beyond 2^23 every float is already a whole number (and might
+    // not fit in an int), so those lanes are kept as they are
+    const __m128 sign = _mm_set1_ps(-0.0f);
+    __m128 truncated = _mm_cvtepi32_ps(_mm_cvttps_epi32(x.data));
+    __m128 floored = _mm_sub_ps(truncated, _mm_and_ps(_mm_cmpgt_ps(truncated, x.data), _mm_set1_ps(1.0f)));
+    floored = _mm_or_ps(floored, _mm_and_ps(sign, x.data));
+    __m128 small = _mm_cmplt_ps(_mm_andnot_ps(sign, x.data), _mm_set1_ps(8388608.0f));
+    return FloatQuad(_mm_or_ps(_mm_and_ps(small, floored), _mm_andnot_ps(small, x.data)));
+#else
+    return FloatQuad(std::floor(x.lanes[0]), std::floor(x.lanes[1]), std::floor(x.lanes[2]), std::floor(x.lanes[3]));
+#endif
+}
+
+inline FloatQuad min(const FloatQuad& a, const FloatQuad& b) { return select(b < a, b, a); }
+inline FloatQuad max(const FloatQuad& a, const FloatQuad& b) { return select(a < b, b, a); }
+
+// The rest are written once for both types
+
+template <typename Float>
+Float fract(const Float& x) { return x - floor(x); }
+
+template <typename Float>
+Float mod(const Float& x, const Float& y) { return x - y * floor(x / y); }
+
+template <typename Float>
+Float clamp(const Float& x, const Float& minValue, const Float& maxValue) { return min(max(x, minValue), maxValue); }
+
+template <typename Float>
+Float mix(const Float& a, const Float& b, const Float& t) { return a * (Float(1.0f) - t) + b * t; }
+
+template <typename Float>
+Float step(const Float& edge, const Float& x) { return select(x < edge, Float(0.0f), Float(1.0f)); }
+
+template <typename Float>
+Float smoothstep(const Float& edge0, const Float& edge1, const Float& x) {
+    Float t = clamp((x - edge0) / (edge1 - edge0), Float(0.0f), Float(1.0f));
+    return t * t * (Float(3.0f) - Float(2.0f) * t);
+}
+
+// vec2 / vec4 over either float type (gl_FragCoord, gl_FragColor)
+template <typename Float>
+struct tvec2 {
+    Float x, y;
+
+    tvec2 operator+(const tvec2& other) const { return { x + other.x, y + other.y }; }
+    tvec2 operator-(const tvec2& other) const { return { x - other.x, y - other.y }; }
+    tvec2 operator*(const Float& scalar) const { return { x * scalar, y * scalar }; }
+};
+
+template <typename Float>
+struct tvec4 {
+    Float x, y, z, w;
+
+    tvec4() = default;
+    tvec4(const Float& x, const Float& y, const Float& z, const Float& w) : x(x), y(y), z(z), w(w) {}
+
+    tvec4 operator+(const tvec4& other) const { return { x + other.x, y + other.y, z + other.z, w + other.w }; }
+    tvec4 operator-(const tvec4& other) const { return { x - other.x, y - other.y, z - other.z, w - other.w }; }
+    tvec4 operator*(const Float& scalar) const { return { x * scalar, y * scalar, z * scalar, w * scalar }; }
+};
+
+typedef tvec2<float> vec2;
+typedef tvec4<float> vec4;
+
+}
@@ -0,0 +1,83 @@
+// 2 element vector, used for grid / screen / heightfield coordinates
+// Only two floats wide, so it stays scalar in every build (a SSE register would be half empty and every
+// operation would pay for the load/store round trip).
+
+#pragma once
+
+#include <iostream>
+#include <cmath>
+#include <stdexcept>
+
+#include "MathConfig.h"
+
+class Vector2 {
+private:
+    // internal representation of a 2D vector
+    // we keep these variables private to prevent public access
+    float x;
+    float y;
+
+public:
+    // default constructor
+    constexpr Vector2(float x = 0.0f, float y = 0.0f) : x(x), y(y) {}
+
+    // Addition of two vectors
+    constexpr Vector2 operator+(const Vector2& other) const
+    {
+        return Vector2(x + other.x, y + other.y);
+    }
+
+    // Subtraction of two vectors
+    constexpr Vector2 operator-(const Vector2& other) const
+    {
+        return Vector2(x - other.x, y - other.y);
+    }
+
+    // Scalar multiplication
+    constexpr Vector2 operator*(float scalar) const
+    {
+        return Vector2(x * scalar, y * scalar);
+    }
+
+    // Scalar division (handles divide-by-zero case)
+    Vector2 operator/(float scalar) const
+    {
+        if (scalar == 0) throw std::runtime_error("Division by zero is not allowed");
+        return Vector2(x / scalar, y / scalar);
+    }
+
+    // Dot product of two vectors
+    constexpr float dot(const Vector2& other) const
+    {
+        return x * other.x + y * other.y;
+    }
+
+    // 2D cross product (z component of the 3D cross product), positive when other is counter-clockwise from this
+    constexpr float cross(const Vector2& other) const
+    {
+        return x * other.y - y * other.x;
+    }
+
+    // Length (magnitude) of the vector
+    float length() const
+    {
+        return std::sqrt(dot(*this));
+    }
+
+    // Returns a unit length copy of this vector (throws on a zero length vector, same as division)
+    Vector2 normalized() const
+    {
+        float len = length();
+        if (len == 0) throw std::runtime_error("Cannot normalize a zero length vector");
+        return Vector2(x / len, y / len);
+    }
+
+    // Component accessors (read only, the data itself stays private)
+    constexpr float getX() const { return x; }
+    constexpr float getY() const { return y; }
+
+    // print to console the provided vector2
+    void print() const {
+        std::cout << "(" << x << ", " << y << ")" << std::endl;
+    }
+};
@@ -0,0 +1,285 @@
+// Structure of arrays storage for Vector3, plus batch kernels that run over whole arrays at once
+
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <algorithm>
+#include <new>
+#include <stdexcept>
+
+#include "MathConfig.h"
+#include "Vector3.h"
+#include "Matrix4x4.h"
+
+// Vector3Array
+// Vector3 is great for working on one vector at a time, but physics/animation code applies the same operation
+// to hundreds of thousands of vectors. Keeping x, y and z in three separate aligned arrays lets the kernels below
+// load 8 x's (or y's, z's) with a single AVX instruction and process 8 vectors per loop iteration.
+// Any leftover elements (count not a multiple of 8), or the whole array when AVX2 is not enabled, go through a scalar tail.
+
+class Vector3Array {
+private:
+    static constexpr std::size_t alignment = 32;  // AVX register width in bytes
+    static constexpr std::size_t laneCount = 8;   // floats per AVX register
+
+    std::size_t count;
+    std::size_t stride;   // count rounded up to a whole number of AVX registers, so every array starts 32-byte aligned
+    float* buffer;        // single allocation holding [x... | y... | z...]
+
+    static std::size_t roundUp(std::size_t n) {
+        return (n + laneCount - 1) / laneCount * laneCount;
+    }
+
+    void allocate() {
+        std::size_t floats = stride * 3;
+        buffer = floats ? static_cast<float*>(::operator new(floats * sizeof(float), std::align_val_t(alignment))) : nullptr;
+        if (buffer) std::fill(buffer, buffer + floats, 0.0f);
+    }
+
+    void release() {
+        if (buffer) ::operator delete(buffer, std::align_val_t(alignment));
+        buffer = nullptr;
+    }
+
+public:
+    // allocates count zero vectors, this is the only place the array allocates
+    explicit Vector3Array(std::size_t count = 0) : count(count), stride(roundUp(count)), buffer(nullptr) {
+        allocate();
+    }
+
+    // Copy constructor
+    Vector3Array(const Vector3Array& other) : count(other.count), stride(other.stride), buffer(nullptr) {
+        allocate();
+        if (buffer) std::copy(other.buffer, other.buffer + stride * 3, buffer);
+    }
+
+    // Copy assignment operator
+    Vector3Array& operator=(const Vector3Array& other) {
+        if (this == &other)
+            return *this;
+
+        release();
+        count = other.count;
+        stride = other.stride;
+        allocate();
+        if (buffer) std::copy(other.buffer, other.buffer + stride * 3, buffer);
+        return *this;
+    }
+
+    ~Vector3Array() {
+        release();
+    }
+
+    // number of vectors stored
+    std::size_t size() const { return count; }
+
+    // raw component arrays, each one is 32-byte aligned and holds size() valid floats
+    float* xs() { return buffer; }
+    float* ys() { return buffer + stride; }
+    float* zs() { return buffer + stride * 2; }
+    const float* xs() const { return buffer; }
+    const float* ys() const { return buffer + stride; }
+    const float* zs() const { return buffer + stride * 2; }
+
+    // write / read a single element (with bounds checking)
+    void set(std::size_t index, const Vector3& v) {
+        if (index >= count)
+            throw std::out_of_range("Index is out of range!");
+        xs()[index] = v.getX();
+        ys()[index] = v.getY();
+        zs()[index] = v.getZ();
+    }
+
+    Vector3 get(std::size_t index) const {
+        if (index >= count)
+            throw std::out_of_range("Index is out of range!");
+        return Vector3(xs()[index], ys()[index], zs()[index]);
+    }
+};
+
+// 3x4 affine transform used by transform(): rows are (m00 m01 m02 tx), (m10 m11 m12 ty), (m20 m21 m22 tz)
+typedef float Matrix3x4[3][4];
+
+// All batch kernels check that the arrays they are given have matching sizes, and allow out to alias an input.
+namespace Vector3Batch {
+
+    inline void checkSize(std::size_t a, std::size_t b) {
+        if (a != b) throw std::invalid_argument("Vector3Array sizes do not match");
+    }
+
+#ifdef MATH_USE_AVX2
+    // a * b + c, fused when the target has FMA
+    inline __m256 multiplyAdd(__m256 a, __m256 b, __m256 c) {
+#ifdef __FMA__
+        return _mm256_fmadd_ps(a, b, c);
+#else
+        return _mm256_add_ps(_mm256_mul_ps(a, b), c);
+#endif
+    }
+#endif
+
+    // dst[i] = lhs[i] + rhs[i] for one component array
+    inline void addComponent(const float* lhs, const float* rhs, float* dst, std::size_t n) {
+        std::size_t i = 0;
+#ifdef MATH_USE_AVX2
+        for (; i + 8 <= n; i += 8)
+            _mm256_store_ps(dst + i, _mm256_add_ps(_mm256_load_ps(lhs + i), _mm256_load_ps(rhs + i)));
+#endif
+        for (; i < n; ++i)
+            dst[i] = lhs[i] + rhs[i];
+    }
+
+    // dst[i] = src[i] * scalar for one component array
+    inline void scaleComponent(const float* src, float scalar, float* dst, std::size_t n) {
+        std::size_t i = 0;
+#ifdef MATH_USE_AVX2
+        const __m256 s = _mm256_set1_ps(scalar);
+        for (; i + 8 <= n; i += 8)
+            _mm256_store_ps(dst + i, _mm256_mul_ps(_mm256_load_ps(src + i), s));
+#endif
+        for (; i < n; ++i)
+            dst[i] = src[i] * scalar;
+    }
+
+    // out[i] = a[i] + b[i]
+    inline void add(const Vector3Array& a, const Vector3Array& b, Vector3Array& out) {
+        checkSize(a.size(), b.size());
+        checkSize(a.size(), out.size());
+        addComponent(a.xs(), b.xs(), out.xs(), a.size());
+        addComponent(a.ys(), b.ys(), out.ys(), a.size());
+        addComponent(a.zs(), b.zs(), out.zs(), a.size());
+    }
+
+    // out[i] = a[i] * scalar
+    inline void scale(const Vector3Array& a, float scalar, Vector3Array& out) {
+        checkSize(a.size(), out.size());
+        scaleComponent(a.xs(), scalar, out.xs(), a.size());
+        scaleComponent(a.ys(), scalar, out.ys(), a.size());
+        scaleComponent(a.zs(), scalar, out.zs(), a.size());
+    }
+
+    // out[i] = dot(a[i], b[i]), out must hold at least a.size() floats
+    inline void dot(const Vector3Array& a, const Vector3Array& b, float* out) {
+        checkSize(a.size(), b.size());
+        const std::size_t n = a.size();
+        std::size_t i = 0;
+#ifdef MATH_USE_AVX2
+        for (; i + 8 <= n; i += 8) {
+            __m256 d = _mm256_mul_ps(_mm256_load_ps(a.xs() + i), _mm256_load_ps(b.xs() + i));
+            d = multiplyAdd(_mm256_load_ps(a.ys() + i), _mm256_load_ps(b.ys() + i), d);
+            d = multiplyAdd(_mm256_load_ps(a.zs() + i), _mm256_load_ps(b.zs() + i), d);
+            _mm256_storeu_ps(out + i, d);
+        }
+#endif
+        for (; i < n; ++i)
+            out[i] = a.xs()[i] * b.xs()[i] + a.ys()[i] * b.ys()[i] + a.zs()[i] * b.zs()[i];
+    }
+
+    // out[i] = cross(a[i], b[i])
+    inline void cross(const Vector3Array& a, const Vector3Array& b, Vector3Array& out) {
+        checkSize(a.size(), b.size());
+        checkSize(a.size(), out.size());
+        const std::size_t n = a.size();
+        std::size_t i = 0;
+#ifdef MATH_USE_AVX2
+        for (; i + 8 <= n; i += 8) {
+            __m256 ax = _mm256_load_ps(a.xs() + i), ay = _mm256_load_ps(a.ys() + i), az = _mm256_load_ps(a.zs() + i);
+            __m256 bx = _mm256_load_ps(b.xs() + i), by = _mm256_load_ps(b.ys() + i), bz = _mm256_load_ps(b.zs() + i);
+            _mm256_store_ps(out.xs() + i, _mm256_sub_ps(_mm256_mul_ps(ay, bz), _mm256_mul_ps(az, by)));
+            _mm256_store_ps(out.ys() + i, _mm256_sub_ps(_mm256_mul_ps(az, bx), _mm256_mul_ps(ax, bz)));
+            _mm256_store_ps(out.zs() + i, _mm256_sub_ps(_mm256_mul_ps(ax, by), _mm256_mul_ps(ay, bx)));
+        }
+#endif
+        for (; i < n; ++i) {
+            float ax = a.xs()[i], ay = a.ys()[i], az = a.zs()[i];
+            float bx = b.xs()[i], by = b.ys()[i], bz = b.zs()[i];
+            out.xs()[i] = ay * bz - az * by;
+            out.ys()[i] = az * bx - ax * bz;
+            out.zs()[i] = ax * by - ay * bx;
+        }
+    }
+
+    // out[i] = length(a[i]), out must hold at least a.size() floats
+    inline void length(const Vector3Array& a, float* out) {
+        const std::size_t n = a.size();
+        std::size_t i = 0;
+#ifdef MATH_USE_AVX2
+        for (; i + 8 <= n; i += 8) {
+            __m256 x = _mm256_load_ps(a.xs() + i), y = _mm256_load_ps(a.ys() + i), z = _mm256_load_ps(a.zs() + i);
+            __m256 lengthSquared = multiplyAdd(z, z, multiplyAdd(y, y, _mm256_mul_ps(x, x)));
+            _mm256_storeu_ps(out + i, _mm256_sqrt_ps(lengthSquared));
+        }
+#endif
+        for (; i < n; ++i)
+            out[i] = std::sqrt(a.xs()[i] * a.xs()[i] + a.ys()[i] * a.ys()[i] + a.zs()[i] * a.zs()[i]);
+    }
+
+    // out[i] = normalized(a[i])
+    // unlike Vector3::normalized() a zero length input does not throw, it simply produces a zero vector
+    // so that the kernel stays branch free
+    inline void normalize(const Vector3Array& a, Vector3Array& out) {
+        checkSize(a.size(), out.size());
+        const std::size_t n = a.size();
+        std::size_t i = 0;
+#ifdef MATH_USE_AVX2
+        const __m256 zero = _mm256_setzero_ps();
+        for (; i + 8 <= n; i += 8) {
+            __m256 x = _mm256_load_ps(a.xs() + i), y = _mm256_load_ps(a.ys() + i), z = _mm256_load_ps(a.zs() + i);
+            __m256 lengthSquared = multiplyAdd(z, z, multiplyAdd(y, y, _mm256_mul_ps(x, x)));
+            __m256 isZero = _mm256_cmp_ps(lengthSquared, zero, _CMP_EQ_OQ);
+            __m256 inverse = _mm256_div_ps(_mm256_set1_ps(1.0f), _mm256_sqrt_ps(lengthSquared));
+            inverse = _mm256_blendv_ps(inverse, zero, isZero);
+            _mm256_store_ps(out.xs() + i, _mm256_mul_ps(x, inverse));
+            _mm256_store_ps(out.ys() + i, _mm256_mul_ps(y, inverse));
+            _mm256_store_ps(out.zs() + i, _mm256_mul_ps(z, inverse));
+        }
+#endif
+        for (; i < n; ++i) {
+            float x = a.xs()[i], y = a.ys()[i], z = a.zs()[i];
+            float len = std::sqrt(x * x + y * y + z * z);
+            float inverse = len == 0 ? 0.0f : 1.0f / len;
+            out.xs()[i] = x * inverse;
+            out.ys()[i] = y * inverse;
+            out.zs()[i] = z * inverse;
+        }
+    }
+
+    // out[i] = m * (a[i], 1), i.e. rotate/scale then translate every point
+    inline void transform(const Matrix3x4& m, const Vector3Array& a, Vector3Array& out) {
+        checkSize(a.size(), out.size());
+        const std::size_t n = a.size();
+        std::size_t i = 0;
+#ifdef MATH_USE_AVX2
+        __m256 row[3][4];
+        for (int r = 0; r < 3; ++r)
+            for (int c = 0; c < 4; ++c)
+                row[r][c] = _mm256_set1_ps(m[r][c]);
+
+        for (; i + 8 <= n; i += 8) {
+            __m256 x = _mm256_load_ps(a.xs() + i), y = _mm256_load_ps(a.ys() + i), z = _mm256_load_ps(a.zs() + i);
+            __m256 result[3];
+            for (int r = 0; r < 3; ++r)
+                result[r] = multiplyAdd(row[r][2], z, multiplyAdd(row[r][1], y, multiplyAdd(row[r][0], x, row[r][3])));
+            _mm256_store_ps(out.xs() + i, result[0]);
+            _mm256_store_ps(out.ys() + i, result[1]);
+            _mm256_store_ps(out.zs() + i, result[2]);
+        }
+#endif
+        for (; i < n; ++i) {
+            float x = a.xs()[i], y = a.ys()[i], z = a.zs()[i];
+            out.xs()[i] = m[0][0] * x + m[0][1] * y + m[0][2] * z + m[0][3];
+            out.ys()[i] = m[1][0] * x + m[1][1] * y + m[1][2] * z + m[1][3];
+            out.zs()[i] = m[2][0] * x + m[2][1] * y + m[2][2] * z + m[2][3];
+        }
+    }
+
+    // out[i] = m.transformPoint(a[i]) for an affine Matrix4x4
+    inline void transform(const Matrix4x4& m, const Vector3Array& a, Vector3Array& out) {
+        Matrix3x4 rows;
+        for (int r = 0; r < 3; ++r)
+            for (int c = 0; c < 4; ++c)
+                rows[r][c] = m(r, c);
+        transform(rows, a, out);
+    }
+}
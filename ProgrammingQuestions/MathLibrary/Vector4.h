@@ -0,0 +1,166 @@
+// 4 element vector, used for homogeneous coordinates and as the column type of Matrix4x4
+// A Vector4 fills a SSE register exactly, so unlike Vector3 it simply uses eager operators (there is no padding lane
+// to maintain and nothing for expression templates to save once the whole vector is a single instruction).
+
+#pragma once
+
+#include <iostream>
+#include <cmath>
+#include <stdexcept>
+
+#include "MathConfig.h"
+#include "Vector3.h"
+
+class alignas(16) Vector4 {
+private:
+#ifdef MATH_USE_SIMD
+    // internal representation of a 4D vector, one SSE register
+    __m128 data;
+
+    // wraps an already computed register, only used internally
+    explicit Vector4(__m128 data) : data(data) {}
+#else
+    // internal representation of a 4D vector
+    // we keep these variables private to prevent public access
+    float x;
+    float y;
+    float z;
+    float w;
+#endif
+
+public:
+#ifdef MATH_USE_SIMD
+    // default constructor
+    Vector4(float x = 0.0f, float y = 0.0f, float z = 0.0f, float w = 0.0f) : data(_mm_set_ps(w, z, y, x)) {}
+
+    // Extends a Vector3 with a w component (1 for points, 0 for directions)
+    // the Vector3 padding lane is already 0, so w just has to be added into it
+    Vector4(const Vector3& v, float w) : data(_mm_add_ps(v.data, _mm_set_ps(w, 0.0f, 0.0f, 0.0f))) {}
+
+    // Addition of two vectors
+    Vector4 operator+(const Vector4& other) const
+    {
+        return Vector4(_mm_add_ps(data, other.data));
+    }
+
+    // Subtraction of two vectors
+    Vector4 operator-(const Vector4& other) const
+    {
+        return Vector4(_mm_sub_ps(data, other.data));
+    }
+
+    // Scalar multiplication
+    Vector4 operator*(float scalar) const
+    {
+        return Vector4(_mm_mul_ps(data, _mm_set1_ps(scalar)));
+    }
+
+    // Scalar division (handles divide-by-zero case)
+    Vector4 operator/(float scalar) const
+    {
+        if (scalar == 0) throw std::runtime_error("Division by zero is not allowed");
+        return Vector4(_mm_div_ps(data, _mm_set1_ps(scalar)));
+    }
+
+    // Dot product of two vectors
+    float dot(const Vector4& other) const
+    {
+        return _mm_cvtss_f32(horizontalSum(_mm_mul_ps(data, other.data)));
+    }
+
+    // Length (magnitude) of the vector
+    float length() const
+    {
+        return _mm_cvtss_f32(_mm_sqrt_ss(horizontalSum(_mm_mul_ps(data, data))));
+    }
+
+    // Returns a unit length copy of this vector (throws on a zero length vector, same as division)
+    Vector4 normalized() const
+    {
+        __m128 lengthSquared = horizontalSum(_mm_mul_ps(data, data));
+        if (_mm_cvtss_f32(lengthSquared) == 0) throw std::runtime_error("Cannot normalize a zero length vector");
+        return Vector4(_mm_div_ps(data, _mm_sqrt_ps(lengthSquared)));
+    }
+
+    // Drops w, zeroing the lane so the result keeps Vector3's padding guarantee
+    Vector3 xyz() const
+    {
+        __m128 zw = _mm_unpackhi_ps(data, _mm_setzero_ps()); // (z, 0, w, 0)
+        return Vector3(_mm_movelh_ps(data, zw));              // (x, y, z, 0)
+    }
+
+    // Component accessors (read only, the data itself stays private)
+    float getX() const { return _mm_cvtss_f32(data); }
+    float getY() const { return _mm_cvtss_f32(_mm_shuffle_ps(data, data, _MM_SHUFFLE(1, 1, 1, 1))); }
+    float getZ() const { return _mm_cvtss_f32(_mm_shuffle_ps(data, data, _MM_SHUFFLE(2, 2, 2, 2))); }
+    float getW() const { return _mm_cvtss_f32(_mm_shuffle_ps(data, data, _MM_SHUFFLE(3, 3, 3, 3))); }
+#else
+    // default constructor
+    constexpr Vector4(float x = 0.0f, float y = 0.0f, float z = 0.0f, float w = 0.0f) : x(x), y(y), z(z), w(w) {}
+
+    // Extends a Vector3 with a w component (1 for points, 0 for directions)
+    constexpr Vector4(const Vector3& v, float w) : x(v.getX()), y(v.getY()), z(v.getZ()), w(w) {}
+
+    // Addition of two vectors
+    constexpr Vector4 operator+(const Vector4& other) const
+    {
+        return Vector4(x + other.x, y + other.y, z + other.z, w + other.w);
+    }
+
+    // Subtraction of two vectors
+    constexpr Vector4 operator-(const Vector4& other) const
+    {
+        return Vector4(x - other.x, y - other.y, z - other.z, w - other.w);
+    }
+
+    // Scalar multiplication
+    constexpr Vector4 operator*(float scalar) const
+    {
+        return Vector4(x * scalar, y * scalar, z * scalar, w * scalar);
+    }
+
+    // Scalar division (handles divide-by-zero case)
+    Vector4 operator/(float scalar) const
+    {
+        if (scalar == 0) throw std::runtime_error("Division by zero is not allowed");
+        return Vector4(x / scalar, y / scalar, z / scalar, w / scalar);
+    }
+
+    // Dot product of two vectors
+    constexpr float dot(const Vector4& other) const
+    {
+        return x * other.x + y * other.y + z * other.z + w * other.w;
+    }
+
+    // Length (magnitude) of the vector
+    float length() const
+    {
+        return std::sqrt(dot(*this));
+    }
+
+    // Returns a unit length copy of this vector (throws on a zero length vector, same as division)
+    Vector4 normalized() const
+    {
+        float len = length();
+        if (len == 0) throw std::runtime_error("Cannot normalize a zero length vector");
+        return Vector4(x / len, y / len, z / len, w / len);
+    }
+
+    // Drops w
+    constexpr Vector3 xyz() const
+    {
+        return Vector3(x, y, z);
+    }
+
+    // Component accessors (read only, the data itself stays private)
+    constexpr float getX() const { return x; }
+    constexpr float getY() const { return y; }
+    constexpr float getZ() const { return z; }
+    constexpr float getW() const { return w; }
+#endif
+
+    // print to console the provided vector4
+    void print() const {
+        std::cout << "(" << getX() << ", " << getY() << ", " << getZ() << ", " << getW() << ")" << std::endl;
+    }
+};
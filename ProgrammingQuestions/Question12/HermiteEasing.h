@@ -0,0 +1,147 @@
+// Baked easing curves: f(x, dx0, dx1) from Question12.frag (cubic Hermite from (0, 0) to (1, 1) with slopes dx0 and
+// dx1, clamped outside [0, 1]) baked for the animation system
+//
+// HermiteEasingTable<Size> keeps two forms of the curve:
+//   Cubic  - the power basis of f, x * (c1 + x * (c2 + x * c3)) with c1 = dx0, c2 = 3 - 2 dx0 - dx1, c3 = dx0 + dx1 - 2,
+//            three multiply-adds and a clamp, exact up to float rounding
+//   Linear - the curve at Size + 1 evenly spaced x, read back with one lerp, error about h^2 / 8 * |f''| with h = 1 / Size
+// Cubic is the default. The table is kept only for the AVX2 Linear batch in evaluate(), which gathers 8 lerps at a
+// time; a scalar lookup costs more than the three multiply-adds. For this curve even that batch is slower than the
+// vectorized cubic, so the table is only worth it for curves that cost more to evaluate than a cubic.
+// Everything is constexpr, so with literal tangents the curve is baked at compile time:
+//   constexpr HermiteEasingTable<64> easeOutBack(2.0f, -1.0f);
+// maxError() reports the worst difference from hermiteEasing(), the analytic curve.
+
+#pragma once
+
+#include <cstddef>
+#include <array>
+
+#include "../MathLibrary/MathConfig.h"
+
+enum class EasingFilter { Linear, Cubic };
+
+// The cubic of f without the clamp, in double (what the tables are baked from)
+constexpr double hermiteCubic(double x, double dx0, double dx1) {
+    double x2 = x * x;
+    double x3 = x2 * x;
+    double h10 = x3 - 2.0 * x2 + x;
+    double h01 = -2.0 * x3 + 3.0 * x2;
+    double h11 = x3 - x2;
+    return h10 * dx0 + h01 + h11 * dx1;
+}
+
+// f(x, dx0, dx1) exactly as in Question12.frag: 0 before x = 0, 1 after x = 1
+constexpr double hermiteEasing(double x, double dx0, double dx1) {
+    return x < 0.0 ? 0.0 : x > 1.0 ? 1.0 : hermiteCubic(x, dx0, dx1);
+}
+
+template <std::size_t Size>
+class HermiteEasingTable {
+    static_assert(Size >= 2, "An easing table needs at least 2 intervals.");
+
+private:
+    float slope0;
+    float slope1;
+    float c1, c2, c3;                     // f(x) = x * (c1 + x * (c2 + x * c3)) inside [0, 1]
+    std::array<float, Size + 1> values;   // values[i] = f(i / Size)
+
+    // interval x falls in and the position inside it, x clamped to [0, 1] (NaN counts as 0)
+    static constexpr std::size_t locate(float x, float& fraction) {
+        float t = (x > 0.0f ? (x < 1.0f ? x : 1.0f) : 0.0f) * static_cast<float>(Size);
+        std::size_t i = static_cast<std::size_t>(t);
+        if (i > Size - 1) i = Size - 1;
+        fraction = t - static_cast<float>(i);
+        return i;
+    }
+
+public:
+    constexpr HermiteEasingTable(float dx0, float dx1)
+        : slope0(dx0), slope1(dx1), c1(dx0), c2(static_cast<float>(3.0 - 2.0 * dx0 - dx1)),
+          c3(static_cast<float>(static_cast<double>(dx0) + dx1 - 2.0)), values() {
+        for (std::size_t i = 0; i <= Size; ++i)
+            values[i] = static_cast<float>(hermiteCubic(static_cast<double>(i) / Size, dx0, dx1));
+    }
+
+    constexpr float getSlope0() const { return slope0; }
+    constexpr float getSlope1() const { return slope1; }
+    static constexpr std::size_t getSize() { return Size; }
+    static constexpr std::size_t memoryUsage() { return sizeof(HermiteEasingTable); }
+
+    // Lerp between the samples around x
+    constexpr float sampleLinear(float x) const {
+        float fraction = 0;
+        std::size_t i = locate(x, fraction);
+        float a = values[i], b = values[i + 1];
+        return a + (b - a) * fraction;
+    }
+
+    // The cubic from its baked coefficients, 0 before x = 0 (and for NaN) and 1 from x = 1 on
+    constexpr float sampleCubic(float x) const {
+        float t = x > 0.0f ? (x < 1.0f ? x : 1.0f) : 0.0f;
+        return t < 1.0f ? t * (c1 + t * (c2 + t * c3)) : 1.0f;
+    }
+
+    constexpr float sample(float x, EasingFilter filter = EasingFilter::Cubic) const {
+        return filter == EasingFilter::Linear ? sampleLinear(x) : sampleCubic(x);
+    }
+
+    // out[i] = sample(in[i], filter) for count values, in and out may be the same array
+    void evaluate(const float* in, float* out, std::size_t count, EasingFilter filter = EasingFilter::Cubic) const {
+        std::size_t i = 0;
+        if (filter == EasingFilter::Cubic) {
+            // the clamps of sampleCubic compile to branches that miss on the out of range times, min / max and a
+            // blend keep the batch free of them
+#if defined(MATH_USE_AVX2)
+            const __m256 zero = _mm256_setzero_ps(), one = _mm256_set1_ps(1.0f);
+            const __m256 b1 = _mm256_set1_ps(c1), b2 = _mm256_set1_ps(c2), b3 = _mm256_set1_ps(c3);
+            for (; i + 8 <= count; i += 8) {
+                __m256 t = _mm256_min_ps(_mm256_max_ps(_mm256_loadu_ps(in + i), zero), one);      // max first, NaN becomes 0
+#ifdef __FMA__
+                __m256 y = _mm256_mul_ps(t, _mm256_fmadd_ps(t, _mm256_fmadd_ps(t, b3, b2), b1));
+#else
+                __m256 y = _mm256_mul_ps(t, _mm256_add_ps(b1, _mm256_mul_ps(t, _mm256_add_ps(b2, _mm256_mul_ps(t, b3)))));
+#endif
+                _mm256_storeu_ps(out + i, _mm256_blendv_ps(y, one, _mm256_cmp_ps(t, one, _CMP_GE_OQ)));
+            }
+#elif defined(MATH_USE_SIMD)
+            const __m128 zero = _mm_setzero_ps(), one = _mm_set1_ps(1.0f);
+            const __m128 b1 = _mm_set1_ps(c1), b2 = _mm_set1_ps(c2), b3 = _mm_set1_ps(c3);
+            for (; i + 4 <= count; i += 4) {
+                __m128 t = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(in + i), zero), one);
+                __m128 y = _mm_mul_ps(t, _mm_add_ps(b1, _mm_mul_ps(t, _mm_add_ps(b2, _mm_mul_ps(t, b3)))));
+                __m128 end = _mm_cmpge_ps(t, one);
+                _mm_storeu_ps(out + i, _mm_or_ps(_mm_and_ps(end, one), _mm_andnot_ps(end, y)));
+            }
+#endif
+            for (; i < count; ++i) out[i] = sampleCubic(in[i]);
+            return;
+        }
+#ifdef MATH_USE_AVX2
+        // same steps as sampleLinear, 8 lanes at a time with both samples gathered from the table
+        const __m256 zero = _mm256_setzero_ps(), one = _mm256_set1_ps(1.0f), size = _mm256_set1_ps(static_cast<float>(Size));
+        const __m256i last = _mm256_set1_epi32(static_cast<int>(Size - 1));
+        for (; i + 8 <= count; i += 8) {
+            __m256 x = _mm256_min_ps(_mm256_max_ps(_mm256_loadu_ps(in + i), zero), one);      // max first, NaN becomes 0
+            __m256 t = _mm256_mul_ps(x, size);
+            __m256i index = _mm256_min_epi32(_mm256_cvttps_epi32(t), last);
+            __m256 fraction = _mm256_sub_ps(t, _mm256_cvtepi32_ps(index));
+            __m256 a = _mm256_i32gather_ps(values.data(), index, 4);
+            __m256 b = _mm256_i32gather_ps(values.data() + 1, index, 4);
+            _mm256_storeu_ps(out + i, _mm256_add_ps(a, _mm256_mul_ps(_mm256_sub_ps(b, a), fraction)));
+        }
+#endif
+        for (; i < count; ++i) out[i] = sampleLinear(in[i]);
+    }
+
+    // Largest difference from the analytic curve over samples + 1 evenly spaced x in [0, 1]
+    double maxError(EasingFilter filter, std::size_t samples = 100000) const {
+        double largest = 0;
+        for (std::size_t i = 0; i <= samples; ++i) {
+            double x = static_cast<double>(i) / samples;
+            double error = sample(static_cast<float>(x), filter) - hermiteEasing(x, slope0, slope1);
+            largest = error > largest ? error : -error > largest ? -error : largest;
+        }
+        return largest;
+    }
+};
@@ -0,0 +1,39 @@
+// Question12.frag ported to C++ for the CPU fragment runner (MathLibrary/FragmentRunner.h)
+//
+// f and main() are line for line the GLSL, templated on the float type so the same code shades one pixel (float)
+// or a 2x2 quad (glsl::FloatQuad). The two early returns of f become selects on the result, which gives the same
+// value for every x since the cubic is finite either way.
+
+#pragma once
+
+#include "../MathLibrary/ShaderMath.h"
+
+struct HermiteShader {
+    float screenWidth = 500.0f;     // gl_FragCoord.x / 500.0 in the GLSL
+    float slope0 = 2.0f;            // dx0, slope at x = 0
+    float slope1 = -1.0f;           // dx1, slope at x = 1
+
+    // Cubic Hermite spline from (0, 0) to (1, 1) with the given end slopes, 0 before x = 0 and 1 after x = 1
+    template <typename Float>
+    static Float f(const Float& x, const Float& dx0, const Float& dx1) {
+        using glsl::select;
+        Float x2 = x * x;
+        Float x3 = x2 * x;
+
+        Float h00 = 2.0f * x3 - 3.0f * x2 + 1.0f;
+        Float h10 = x3 - 2.0f * x2 + x;
+        Float h01 = -2.0f * x3 + 3.0f * x2;
+        Float h11 = x3 - x2;
+
+        Float y = h00 * 0.0f + h10 * dx0 + h01 * 1.0f + h11 * dx1;
+        return select(x < 0.0f, Float(0.0f), select(x > 1.0f, Float(1.0f), y));
+    }
+
+    // main(): gl_FragColor from gl_FragCoord
+    template <typename Float>
+    glsl::tvec4<Float> operator()(const glsl::tvec4<Float>& gl_FragCoord) const {
+        Float x = gl_FragCoord.x / screenWidth;     // Normalize x to [0, 1] based on screen width
+        Float y = f(x, Float(slope0), Float(slope1));
+        return glsl::tvec4<Float>(y, y, y, 1.0f);   // Visualize the function as grayscale
+    }
+};
@@ -0,0 +1,106 @@
+// Question12.frag (cubic Hermite f) run on the CPU
+// The shader is ported in HermiteShader.h and rendered with the fragment runner from MathLibrary, so its output can be
+// checked without a GPU. Pass the path of a golden PPM to compare the 500x101 render against it (the exit code is 1
+// on any difference); the render itself is always written to the temp directory.
+
+#include <algorithm>
+#include <iostream>
+#include <chrono>
+#include <filesystem>
+#include <string>
+#include <random>
+#include <vector>
+
+#include "../MathLibrary/FragmentRunner.h"
+#include "HermiteShader.h"
+#include "HermiteEasing.h"
+
+using namespace std;
+
+// the curve of the shader, baked while compiling
+constexpr HermiteEasingTable<64> shaderEasing(2.0f, -1.0f);
+static_assert(shaderEasing.sampleLinear(0.0f) == 0.0f && shaderEasing.sampleLinear(1.0f) == 1.0f, "The table must hit both ends exactly.");
+static_assert(shaderEasing.sampleCubic(0.0f) == 0.0f && shaderEasing.sampleCubic(1.0f) == 1.0f, "The cubic must hit both ends exactly.");
+
+template <std::size_t Size>
+void printEasingError(float dx0, float dx1) {
+    HermiteEasingTable<Size> table(dx0, dx1);
+    cout << "  " << Size << " intervals (" << table.memoryUsage() << " bytes): linear " << table.maxError(EasingFilter::Linear)
+         << ", cubic " << table.maxError(EasingFilter::Cubic) << endl;
+}
+
+// Largest error of the tables against the analytic f, and the time per sample for many animated properties
+void runEasingBenchmarks() {
+    cout << endl << "Easing tables, largest error against f(x, 2, -1)" << endl;
+    printEasingError<16>(2.0f, -1.0f);
+    printEasingError<64>(2.0f, -1.0f);
+    printEasingError<256>(2.0f, -1.0f);
+    cout << "Easing tables, largest error against f(x, 0, 0) (smoothstep)" << endl;
+    printEasingError<16>(0.0f, 0.0f);
+    printEasingError<64>(0.0f, 0.0f);
+
+    // animation times of a million properties, some before their start or past their end
+    const size_t count = 1 << 20;
+    const int repeats = 4;
+    vector<float> times(count), eased(count);
+    mt19937 random(12);
+    uniform_real_distribution<float> time(-0.1f, 1.1f);
+    for (float& t : times) t = time(random);
+
+    // best of 5 runs, the VM this was measured on is noisy
+    auto run = [&](auto&& evaluate) {
+        evaluate();     // warm up
+        double best = 1e30;
+        for (int attempt = 0; attempt < 5; ++attempt) {
+            auto t0 = chrono::high_resolution_clock::now();
+            for (int r = 0; r < repeats; ++r) evaluate();
+            auto t1 = chrono::high_resolution_clock::now();
+            best = std::min(best, chrono::duration<double, nano>(t1 - t0).count() / (static_cast<double>(count) * repeats));
+        }
+        return best;
+    };
+    double analytic = run([&] {
+        for (size_t i = 0; i < count; ++i) eased[i] = HermiteShader::f(times[i], 2.0f, -1.0f);
+    });
+    float check = eased[count / 2];
+    double linear = run([&] { shaderEasing.evaluate(times.data(), eased.data(), count, EasingFilter::Linear); });
+    double cubic = run([&] { shaderEasing.evaluate(times.data(), eased.data(), count, EasingFilter::Cubic); });
+
+    cout << count << " properties: f " << analytic << " ns, table linear " << linear << " ns, baked cubic " << cubic
+         << " ns per sample (f(t) = " << check << ", baked cubic " << eased[count / 2] << ")" << endl;
+}
+
+int main(int argc, char** argv)
+{
+    HermiteShader shader;
+    for (float x : { -0.5f, 0.0f, 0.25f, 0.5f, 0.75f, 1.0f, 1.5f }) {
+        cout << "f(" << x << ") = " << HermiteShader::f(x, shader.slope0, shader.slope1) << endl;
+    }
+
+    // the size the GLSL was written for (x / 500), the odd height leaves half empty quads in the last row
+    FragmentImage image(500, 101), reference(500, 101);
+    renderFragments(shader, image);
+    renderFragmentsScalar(shader, reference);
+    cout << "Quads against single pixels, largest difference: " << image.compare(reference) << endl;
+
+    string path = (filesystem::temp_directory_path() / "question12.ppm").string();
+    cout << (image.writePPM(path) ? "Written to " + path : "Could not write " + path) << endl;
+
+    int result = 0;
+    if (argc > 1) {
+        FragmentImage golden;
+        if (!golden.readPPM(argv[1])) {
+            cout << "Could not read the golden image " << argv[1] << endl;
+            result = 1;
+        }
+        else {
+            int difference = image.compare(golden);
+            cout << "Golden image " << argv[1] << ": " << (difference == 0 ? "match" : "DIFFERENT") << " (largest difference " << difference << ")" << endl;
+            result = difference == 0 ? 0 : 1;
+        }
+    }
+
+    runFragmentBenchmarks(shader);
+    runEasingBenchmarks();
+    return result;
+}
@@ -0,0 +1,35 @@
+// Question13.frag ported to C++ for the CPU fragment runner (MathLibrary/FragmentRunner.h)
+//
+// mirror_repeat and main() are line for line the GLSL, templated on the float type so the same code shades one pixel
+// (float) or a 2x2 quad (glsl::FloatQuad). glsl::mod is GLSL's x - y * floor(x / y), so negative x wrap the way they do
+// on the GPU and not like std::fmod.
+// As in the GLSL the result lies in [a, b] = [1, 2], so every pixel of the visualization clamps to white.
+
+#pragma once
+
+#include "../MathLibrary/ShaderMath.h"
+
+struct MirrorRepeatShader {
+    float screenWidth = 500.0f;     // gl_FragCoord.x / 500.0 * 4.0 in the GLSL
+    float a = 1.0f;                 // Start of the interval
+    float b = 2.0f;                 // End of the interval
+
+    template <typename Float>
+    static Float mirror_repeat(Float x, const Float& a, const Float& b) {
+        using glsl::abs; using glsl::mod;
+        Float interval = b - a;
+        x = x - a;                          // Shift x to start from 0
+        x = mod(x, 2.0f * interval);        // Wrap x into [0, 2*interval]
+        x = abs(x - interval);              // Mirror within [0, interval]
+        x = x + a;                          // Shift back to [a, b]
+        return x;
+    }
+
+    // main(): gl_FragColor from gl_FragCoord
+    template <typename Float>
+    glsl::tvec4<Float> operator()(const glsl::tvec4<Float>& gl_FragCoord) const {
+        Float x = gl_FragCoord.x / screenWidth * 4.0f;  // Scale x to [0, 4] for visualization
+        Float y = mirror_repeat(x, Float(a), Float(b));
+        return glsl::tvec4<Float>(y, y, y, 1.0f);       // Visualize the function as grayscale
+    }
+};
@@ -0,0 +1,129 @@
+// Question13.frag (mirror_repeat) run on the CPU
+// The shader is ported in MirrorRepeatShader.h and rendered with the fragment runner from MathLibrary, so its output can be
+// checked without a GPU. Pass the path of a golden PPM to compare the 500x101 render against it (the exit code is 1
+// on any difference); the render itself is always written to the temp directory.
+
+#include <iostream>
+#include <chrono>
+#include <filesystem>
+#include <string>
+#include <cstring>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "../MathLibrary/FragmentRunner.h"
+#include "MirrorRepeatShader.h"
+#include "TextureAddressing.h"
+
+using namespace std;
+
+const char* addressName(TextureAddress mode) {
+    switch (mode) {
+    case TextureAddress::Repeat: return "repeat";
+    case TextureAddress::MirrorRepeat: return "mirror repeat";
+    case TextureAddress::Clamp: return "clamp";
+    default: return "mirror once";
+    }
+}
+
+// Negative coordinates against std::fmod, then millions of coordinates per mode for one coordinate at a time and the
+// batch, which must give exactly the same bits
+void runAddressingBenchmarks() {
+    const TextureAddress modes[] = { TextureAddress::Repeat, TextureAddress::MirrorRepeat, TextureAddress::Clamp, TextureAddress::MirrorOnce };
+    cout << endl << "Addressing into [1, 2]" << endl;
+    for (float x : { -2.75f, -1.0f, -0.25f, -1e-8f, 0.5f, 1.25f, 3.5f }) {
+        cout << "  x = " << x << ": fmod repeat " << 1.0f + fmod(x - 1.0f, 1.0f);
+        for (TextureAddress mode : modes) cout << ", " << addressName(mode) << " " << TextureAddressing::address(mode, x, 1.0f, 2.0f);
+        cout << endl;
+    }
+
+    using TextureAddressing::Fixed;
+    const size_t count = 1 << 22;
+    const int repeats = 10;
+    vector<float> coordinates(count), single(count), batch(count);
+    vector<Fixed> fixedCoordinates(count), fixedSingle(count), fixedBatch(count);
+    mt19937 random(13);
+    uniform_real_distribution<float> coordinate(-8.0f, 8.0f);
+    for (size_t i = 0; i < count; ++i) {
+        coordinates[i] = coordinate(random);
+        fixedCoordinates[i] = TextureAddressing::toFixed(coordinates[i]);
+    }
+    const float a = 0.25f, b = 1.75f;
+    const Fixed fixedA = TextureAddressing::toFixed(a), fixedB = TextureAddressing::toFixed(b);
+
+    auto time = [&](auto&& run) {
+        run();      // warm up
+        auto t0 = chrono::high_resolution_clock::now();
+        for (int r = 0; r < repeats; ++r) run();
+        auto t1 = chrono::high_resolution_clock::now();
+        return count * static_cast<double>(repeats) / chrono::duration<double, micro>(t1 - t0).count();
+    };
+
+    cout << count << " coordinates into [" << a << ", " << b << "], million coordinates per second (one at a time / batch)" << endl;
+    for (TextureAddress mode : modes) {
+        double floatSingle = time([&] {
+            for (size_t i = 0; i < count; ++i) single[i] = TextureAddressing::address(mode, coordinates[i], a, b);
+        });
+        double floatBatch = time([&] { TextureAddressing::addressBatch(mode, coordinates.data(), batch.data(), count, a, b); });
+        double fixedOne = time([&] {
+            for (size_t i = 0; i < count; ++i) fixedSingle[i] = TextureAddressing::address(mode, fixedCoordinates[i], fixedA, fixedB);
+        });
+        double fixedMany = time([&] { TextureAddressing::addressBatch(mode, fixedCoordinates.data(), fixedBatch.data(), count, fixedA, fixedB); });
+
+        // the float results bit for bit against the batch and the shader's own mirror_repeat, the fixed point ones
+        // against the float results
+        size_t different = 0, fixedDifferent = 0;
+        double fixedError = 0;
+        for (size_t i = 0; i < count; ++i) {
+            different += memcmp(&single[i], &batch[i], sizeof(float)) != 0;
+            if (mode == TextureAddress::MirrorRepeat) {
+                float shader = MirrorRepeatShader::mirror_repeat(coordinates[i], a, b);
+                different += memcmp(&single[i], &shader, sizeof(float)) != 0;
+            }
+            fixedDifferent += fixedSingle[i] != fixedBatch[i];
+            double error = fabs(TextureAddressing::fromFixed(fixedSingle[i]) - single[i]);
+            // a and b are the same point of a repeated texture, float rounding can land on either
+            if (mode == TextureAddress::Repeat) error = min(error, fabs(error - (b - a)));
+            fixedError = max(fixedError, error);
+        }
+        cout << "  " << addressName(mode) << ": float " << floatSingle << " / " << floatBatch << ", fixed " << fixedOne << " / " << fixedMany
+             << " (differing bits " << different << ", fixed " << fixedDifferent << ", largest fixed - float " << fixedError << ")" << endl;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    MirrorRepeatShader shader;
+    // negative x too, where GLSL's mod differs from std::fmod
+    for (float x : { -1.5f, -0.25f, 0.0f, 0.5f, 1.0f, 1.5f, 2.0f, 2.5f, 3.0f, 4.0f }) {
+        cout << "mirror_repeat(" << x << ") = " << MirrorRepeatShader::mirror_repeat(x, shader.a, shader.b) << endl;
+    }
+
+    // the size the GLSL was written for (x / 500 * 4), the odd height leaves half empty quads in the last row
+    FragmentImage image(500, 101), reference(500, 101);
+    renderFragments(shader, image);
+    renderFragmentsScalar(shader, reference);
+    cout << "Quads against single pixels, largest difference: " << image.compare(reference) << endl;
+
+    string path = (filesystem::temp_directory_path() / "question13.ppm").string();
+    cout << (image.writePPM(path) ? "Written to " + path : "Could not write " + path) << endl;
+
+    int result = 0;
+    if (argc > 1) {
+        FragmentImage golden;
+        if (!golden.readPPM(argv[1])) {
+            cout << "Could not read the golden image " << argv[1] << endl;
+            result = 1;
+        }
+        else {
+            int difference = image.compare(golden);
+            cout << "Golden image " << argv[1] << ": " << (difference == 0 ? "match" : "DIFFERENT") << " (largest difference " << difference << ")" << endl;
+            result = difference == 0 ? 0 : 1;
+        }
+    }
+
+    runFragmentBenchmarks(shader);
+    runAddressingBenchmarks();
+    return result;
+}
@@ -0,0 +1,191 @@
+// Texture addressing (wrap, clamp and mirror of coordinates into [a, b]) for the CPU side texture sampler, tile maps and
+// UV tools, built on mirror_repeat from Question13.frag
+//
+//   Repeat       - a + mod(x - a, b - a)
+//   MirrorRepeat - mirror_repeat(x, a, b) from the shader: abs(mod(x - a, 2 * (b - a)) - (b - a)) + a
+//                  (like the GLSL it maps a to b and b to a, the mirrored copy comes first)
+//   Clamp        - clamp(x, a, b)
+//   MirrorOnce   - mirrored once around a, then clamped: a + min(abs(x - a), b - a)
+// mod is GLSL's x - y * floor(x / y), so negative coordinates wrap up into the interval instead of keeping their sign
+// like std::fmod. The float versions do exactly the operations of the GLSL, in the same order and without fused
+// multiply-adds, so the scalar functions, the AVX2 batches and glsl::mod in the shader port agree to the bit for every
+// input (including mod's rounding: a tiny negative x can come out as exactly b, the same as on the GPU).
+//
+// Fixed point coordinates are Q16.16 (Fixed, 1.0 == 65536). Their mod is exact (no rounding at all), through 64 bit
+// integers in the scalar code and doubles in the AVX2 code (AVX2 has no integer division, and an int32 quotient and
+// remainder are exact in a double). Coordinates and interval ends are expected within +-2^30 (+-16384.0) so that
+// differences and 2 * (b - a) stay inside an int32.
+// addressBatch runs one mode over an array, 8 coordinates per AVX2 instruction when it is enabled and the scalar
+// functions otherwise.
+
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <algorithm>
+
+#include "../MathLibrary/MathConfig.h"
+#include "../MathLibrary/ShaderMath.h"
+#include "MirrorRepeatShader.h"
+
+enum class TextureAddress { Repeat, MirrorRepeat, Clamp, MirrorOnce };
+
+namespace TextureAddressing {
+
+    // Float, one coordinate
+
+    inline float repeat(float x, float a, float b) {
+        return a + glsl::mod(x - a, b - a);
+    }
+
+    inline float mirrorRepeat(float x, float a, float b) {
+        return MirrorRepeatShader::mirror_repeat(x, a, b);
+    }
+
+    inline float clamp(float x, float a, float b) {
+        return glsl::clamp(x, a, b);
+    }
+
+    inline float mirrorOnce(float x, float a, float b) {
+        return a + glsl::min(glsl::abs(x - a), b - a);
+    }
+
+    inline float address(TextureAddress mode, float x, float a, float b) {
+        switch (mode) {
+        case TextureAddress::Repeat: return repeat(x, a, b);
+        case TextureAddress::MirrorRepeat: return mirrorRepeat(x, a, b);
+        case TextureAddress::Clamp: return clamp(x, a, b);
+        default: return mirrorOnce(x, a, b);
+        }
+    }
+
+    // Fixed point, one coordinate
+
+    typedef std::int32_t Fixed;
+    constexpr int fixedShift = 16;
+
+    constexpr Fixed toFixed(float value) { return static_cast<Fixed>(value * (1 << fixedShift)); }
+    constexpr float fromFixed(Fixed value) { return static_cast<float>(value) / (1 << fixedShift); }
+
+    // x - y * floor(x / y) for y > 0, always in [0, y)
+    inline std::int64_t floorMod(std::int64_t x, std::int64_t y) {
+        std::int64_t remainder = x % y;
+        return remainder < 0 ? remainder + y : remainder;
+    }
+
+    inline Fixed repeat(Fixed x, Fixed a, Fixed b) {
+        return static_cast<Fixed>(a + floorMod(static_cast<std::int64_t>(x) - a, static_cast<std::int64_t>(b) - a));
+    }
+
+    inline Fixed mirrorRepeat(Fixed x, Fixed a, Fixed b) {
+        std::int64_t interval = static_cast<std::int64_t>(b) - a;
+        std::int64_t wrapped = floorMod(static_cast<std::int64_t>(x) - a, 2 * interval) - interval;
+        return static_cast<Fixed>((wrapped < 0 ? -wrapped : wrapped) + a);
+    }
+
+    inline Fixed clamp(Fixed x, Fixed a, Fixed b) {
+        return std::min(std::max(x, a), b);
+    }
+
+    inline Fixed mirrorOnce(Fixed x, Fixed a, Fixed b) {
+        std::int64_t distance = static_cast<std::int64_t>(x) - a;
+        return static_cast<Fixed>(a + std::min<std::int64_t>(distance < 0 ? -distance : distance, static_cast<std::int64_t>(b) - a));
+    }
+
+    inline Fixed address(TextureAddress mode, Fixed x, Fixed a, Fixed b) {
+        switch (mode) {
+        case TextureAddress::Repeat: return repeat(x, a, b);
+        case TextureAddress::MirrorRepeat: return mirrorRepeat(x, a, b);
+        case TextureAddress::Clamp: return clamp(x, a, b);
+        default: return mirrorOnce(x, a, b);
+        }
+    }
+
+#ifdef MATH_USE_AVX2
+    // 8 lanes of the float functions above, the same operations in the same order
+    inline __m256 mod8(__m256 x, __m256 y) {
+        return _mm256_sub_ps(x, _mm256_mul_ps(y, _mm256_floor_ps(_mm256_div_ps(x, y))));
+    }
+
+    inline __m256 abs8(__m256 x) {
+        return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), x);
+    }
+
+    template <TextureAddress Mode>
+    inline __m256 address8(__m256 x, __m256 a, __m256 b) {
+        if (Mode == TextureAddress::Repeat) return _mm256_add_ps(a, mod8(_mm256_sub_ps(x, a), _mm256_sub_ps(b, a)));
+        if (Mode == TextureAddress::MirrorRepeat) {
+            __m256 interval = _mm256_sub_ps(b, a);
+            __m256 wrapped = mod8(_mm256_sub_ps(x, a), _mm256_mul_ps(_mm256_set1_ps(2.0f), interval));
+            return _mm256_add_ps(abs8(_mm256_sub_ps(wrapped, interval)), a);
+        }
+        // glsl::max(x, a) is x < a ? a : x, which is maxps(a, x) = a > x ? a : x (the same for equal values and NaN),
+        // and glsl::min likewise with the operands swapped
+        if (Mode == TextureAddress::Clamp) return _mm256_min_ps(b, _mm256_max_ps(a, x));
+        return _mm256_add_ps(a, _mm256_min_ps(_mm256_sub_ps(b, a), abs8(_mm256_sub_ps(x, a))));
+    }
+
+    // floor mod of 4 exact integers held in doubles, y > 0
+    inline __m256d floorMod4(__m256d x, __m256d y) {
+        return _mm256_sub_pd(x, _mm256_mul_pd(y, _mm256_floor_pd(_mm256_div_pd(x, y))));
+    }
+
+    // 8 lanes of the Fixed functions above, the mods done in two halves of 4 doubles
+    template <TextureAddress Mode>
+    inline __m256i address8(__m256i x, Fixed a, Fixed b) {
+        if (Mode == TextureAddress::Clamp) return _mm256_min_epi32(_mm256_max_epi32(x, _mm256_set1_epi32(a)), _mm256_set1_epi32(b));
+        if (Mode == TextureAddress::MirrorOnce) {
+            __m256i distance = _mm256_abs_epi32(_mm256_sub_epi32(x, _mm256_set1_epi32(a)));
+            return _mm256_add_epi32(_mm256_set1_epi32(a), _mm256_min_epi32(distance, _mm256_set1_epi32(b - a)));
+        }
+
+        const __m256d start = _mm256_set1_pd(a);
+        const __m256d interval = _mm256_set1_pd(static_cast<double>(b) - a);
+        const __m256d period = Mode == TextureAddress::Repeat ? interval : _mm256_add_pd(interval, interval);
+        __m256d low = floorMod4(_mm256_sub_pd(_mm256_cvtepi32_pd(_mm256_castsi256_si128(x)), start), period);
+        __m256d high = floorMod4(_mm256_sub_pd(_mm256_cvtepi32_pd(_mm256_extracti128_si256(x, 1)), start), period);
+        if (Mode == TextureAddress::MirrorRepeat) {
+            const __m256d sign = _mm256_set1_pd(-0.0);
+            low = _mm256_andnot_pd(sign, _mm256_sub_pd(low, interval));
+            high = _mm256_andnot_pd(sign, _mm256_sub_pd(high, interval));
+        }
+        __m256i result = _mm256_set_m128i(_mm256_cvtpd_epi32(high), _mm256_cvtpd_epi32(low));
+        return _mm256_add_epi32(result, _mm256_set1_epi32(a));
+    }
+#endif
+
+    template <TextureAddress Mode>
+    inline void addressBatch(const float* in, float* out, std::size_t count, float a, float b) {
+        std::size_t i = 0;
+#ifdef MATH_USE_AVX2
+        const __m256 start = _mm256_set1_ps(a), end = _mm256_set1_ps(b);
+        for (; i + 8 <= count; i += 8)
+            _mm256_storeu_ps(out + i, address8<Mode>(_mm256_loadu_ps(in + i), start, end));
+#endif
+        for (; i < count; ++i) out[i] = address(Mode, in[i], a, b);
+    }
+
+    template <TextureAddress Mode>
+    inline void addressBatch(const Fixed* in, Fixed* out, std::size_t count, Fixed a, Fixed b) {
+        std::size_t i = 0;
+#ifdef MATH_USE_AVX2
+        for (; i + 8 <= count; i += 8) {
+            __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), address8<Mode>(x, a, b));
+        }
+#endif
+        for (; i < count; ++i) out[i] = address(Mode, in[i], a, b);
+    }
+
+    // out[i] = address(mode, in[i], a, b) for count coordinates, in and out may be the same array
+    template <typename Coordinate>
+    void addressBatch(TextureAddress mode, const Coordinate* in, Coordinate* out, std::size_t count, Coordinate a, Coordinate b) {
+        switch (mode) {
+        case TextureAddress::Repeat: addressBatch<TextureAddress::Repeat>(in, out, count, a, b); break;
+        case TextureAddress::MirrorRepeat: addressBatch<TextureAddress::MirrorRepeat>(in, out, count, a, b); break;
+        case TextureAddress::Clamp: addressBatch<TextureAddress::Clamp>(in, out, count, a, b); break;
+        case TextureAddress::MirrorOnce: addressBatch<TextureAddress::MirrorOnce>(in, out, count, a, b); break;
+        }
+    }
+}
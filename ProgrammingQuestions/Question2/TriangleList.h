@@ -0,0 +1,78 @@
+// Color, Triangle (3 positions, 3 colours and a face normal) and TriangleList, a std::vector of triangles
+
+#pragma once
+
+#include <cstddef>
+#include <stdexcept>
+#include <vector>
+
+// vertex positions and normals use the shared math library's Vector3 (and Matrix4x4 for transforms)
+#include "../MathLibrary/MathLibrary.h"
+
+// likewise, a similar struct to hold color data for vertices
+struct Color {
+    float r, g, b;
+
+    Color(float r = 255, float g = 255, float b = 255) : r(r), g(g), b(b) {}
+};
+
+
+struct Triangle {
+    Vector3 vertices[3];    // array of 3 vertices required for creating a triangle
+    Color colors[3];        // array of 3 colors assigned to each vertex - we can also create a color variable inside the vector3 struct
+    Vector3 normal;         // Face normal of the triangle - for sake of complexity, we will assume the normal has already been calculated
+
+    Triangle(const Vector3& v1, const Vector3& v2, const Vector3& v3,
+        const Color& c1, const Color& c2, const Color& c3,
+        const Vector3& normal) :
+        vertices{v1, v2, v3}, colors{c1, c2, c3}, normal(normal) {}
+
+    // same as above, but the face normal is calculated from the (counter-clockwise) winding of the vertices
+    Triangle(const Vector3& v1, const Vector3& v2, const Vector3& v3,
+        const Color& c1, const Color& c2, const Color& c3) :
+        vertices{v1, v2, v3}, colors{c1, c2, c3}, normal((v2 - v1).cross(v3 - v1).normalized()) {}
+};
+
+class TriangleList {
+private:
+    std::vector<Triangle> triangles;    // vector to store list of triangles
+
+public:
+    TriangleList() = default;
+
+    // add a triangle to the list
+    void addTriangle(const Triangle& triangle) {
+        triangles.push_back(triangle);
+    }
+
+    // retrieve a triangle from the specified index
+    const Triangle& getTriangle(size_t index) const {
+        if (index >= triangles.size()) {
+            throw std::out_of_range("Index is out of range!");
+        }
+
+        return triangles[index];
+    }
+
+    // get the total number of triangles inside the list
+    size_t size() const {
+        return triangles.size();
+    }
+
+    // transform every triangle in the list, e.g. from model space to world space
+    // positions are transformed as points, normals with the inverse transpose so that they stay perpendicular
+    // to their faces under non-uniform scale
+    void transform(const Matrix4x4& matrix) {
+        Matrix3x3 normalMatrix = matrix.linearPart().inverse().transposed();
+        for (Triangle& triangle : triangles) {
+            matrix.transformPoints(triangle.vertices, triangle.vertices, 3);
+            triangle.normal = (normalMatrix * triangle.normal).normalized();
+        }
+    }
+
+    // we can add further methods like below to augment functionality................
+    void drawTriangle(size_t index) {
+        //draw specified triangle at the given index
+    }
+
+};
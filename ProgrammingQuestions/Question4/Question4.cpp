@@ -3,69 +3,220 @@
 // Please support simple operations on the vector such as addition, subtraction, multiplication and division as well as dot and cross product.
 
 
+// The Vector3 class itself now lives in the shared math library (MathLibrary/Vector3.h), together with the
+// Vector3Array batch kernels, so that the other questions can use the same type. This file demonstrates and benchmarks it.
+
 #include <iostream>
 #include <cmath>
+#include <chrono>
+#include <cstddef>
+#include <vector>
+#include <random>
+#include <algorithm>
 
-class Vector3 {
-private:
-    // internal representation of a 3D vector
-    // we keep these variables private to prevent public access
-    float x;
-    float y;
-    float z;
-
-public:
-    // default constructor
-    Vector3(float x = 0.0f, float y = 0.0f, float z = 0.0f) : x(x), y(y), z(z) {}
-
-    // Addition of two vectors
-    Vector3 operator+(const Vector3& other) const 
-    {
-        return Vector3(x + other.x, y + other.y, z + other.z);
-    }
+#include "../MathLibrary/Vector3.h"
+#include "../MathLibrary/Vector3Array.h"
+
+
+// ---------------------------------------------------------------------------------------------
+// Micro-benchmarks
+// ScalarVector3 is the original three-float implementation, kept here only as a baseline to compare against
+// ---------------------------------------------------------------------------------------------
+
+struct ScalarVector3 {
+    float x, y, z;
+
+    ScalarVector3(float x = 0.0f, float y = 0.0f, float z = 0.0f) : x(x), y(y), z(z) {}
 
-    // Subtraction of two vectors
-    Vector3 operator-(const Vector3& other) const 
-    {
-        return Vector3(x - other.x, y - other.y, z - other.z);
+    ScalarVector3 operator+(const ScalarVector3& o) const { return ScalarVector3(x + o.x, y + o.y, z + o.z); }
+    ScalarVector3 operator-(const ScalarVector3& o) const { return ScalarVector3(x - o.x, y - o.y, z - o.z); }
+    ScalarVector3 operator*(float s) const { return ScalarVector3(x * s, y * s, z * s); }
+    float dot(const ScalarVector3& o) const { return x * o.x + y * o.y + z * o.z; }
+    ScalarVector3 cross(const ScalarVector3& o) const { return ScalarVector3(y * o.z - z * o.y, z * o.x - x * o.z, x * o.y - y * o.x); }
+    float length() const { return std::sqrt(dot(*this)); }
+    ScalarVector3 normalized() const { float len = length(); return ScalarVector3(x / len, y / len, z / len); }
+};
+
+// Runs the same chain of operations on either vector type and returns nanoseconds per iteration
+// the accumulated result is fed back into the loop (and printed) so the compiler cannot throw the work away
+template <typename Vec>
+double benchmarkVectorOps(const char* label, int iterations)
+{
+    Vec a(1.0f, 2.0f, 3.0f);
+    Vec b(0.5f, -1.0f, 0.25f);
+    Vec acc(0.0f, 0.0f, 1.0f);
+    float sum = 0.0f;
+
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        acc = (acc + a.cross(b) * 0.001f).normalized();
+        sum += acc.dot(b) + acc.length();
     }
+    auto end = std::chrono::high_resolution_clock::now();
+
+    double ns = std::chrono::duration<double, std::nano>(end - start).count() / iterations;
+    std::cout << label << ": " << ns << " ns/iteration (checksum " << sum << ")" << std::endl;
+    return ns;
+}
 
-    // Scalar multiplication
-    Vector3 operator*(float scalar) const 
-    {
-        return Vector3(x * scalar, y * scalar, z * scalar);
+// A typical explicit Euler/Verlet style integration step, the kind of expression the expression templates are aimed at
+// the loop is only a few nanoseconds per iteration, so the best of 5 runs is reported to keep timer and scheduling
+// noise out of the comparison
+template <typename Vec>
+double benchmarkIntegrator(const char* label, int iterations)
+{
+    Vec position, velocity;
+    const Vec acceleration(0.0f, -9.8f, 0.0f);
+    const Vec drag(0.01f, 0.0f, 0.01f);
+    const float dt = 1.0f / 60.0f;
+
+    double ns = 0;
+    for (int run = 0; run < 5; ++run) {
+        position = Vec(0.0f, 10.0f, 0.0f);
+        velocity = Vec(1.0f, 0.0f, 0.5f);
+        auto start = std::chrono::high_resolution_clock::now();
+        for (int i = 0; i < iterations; ++i) {
+            position = position + velocity * dt + acceleration * (0.5f * dt * dt) - drag * dt;
+            velocity = velocity + acceleration * dt;
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+        double runNs = std::chrono::duration<double, std::nano>(end - start).count() / iterations;
+        ns = run == 0 ? runNs : std::min(ns, runNs);
     }
+    std::cout << label << ": " << ns << " ns/iteration (checksum " << position.dot(velocity) << ")" << std::endl;
+    return ns;
+}
+
+void runBenchmarks()
+{
+    const int iterations = 5000000;
+    std::cout << std::endl << "Benchmark (" << iterations << " iterations of add, scale, cross, normalize, dot, length)" << std::endl;
+    double scalar = benchmarkVectorOps<ScalarVector3>("  Scalar", iterations);
+#ifdef MATH_USE_SIMD
+    double vector3 = benchmarkVectorOps<Vector3>("  Vector3 (SSE)", iterations);
+#else
+    double vector3 = benchmarkVectorOps<Vector3>("  Vector3 (scalar build)", iterations);
+#endif
+    std::cout << "  Speedup: " << scalar / vector3 << "x" << std::endl;
+
+    std::cout << "Integrator benchmark (p = p + v * dt + a * (0.5 * dt * dt) - drag * dt, v = v + a * dt)" << std::endl;
+    double eager = benchmarkIntegrator<ScalarVector3>("  Scalar, one temporary per operator", iterations);
+    double fused = benchmarkIntegrator<Vector3>("  Vector3 expression templates", iterations);
+    std::cout << "  Speedup: " << eager / fused << "x" << std::endl;
+}
+
+// Times one batch kernel over a large array and reports the effective memory throughput
+// (bytes read + bytes written per pass), which is the number to compare against the machine's memory bandwidth
+template <typename Kernel>
+void benchmarkBatchKernel(const char* label, std::size_t bytesPerVector, std::size_t count, int passes, Kernel kernel)
+{
+    kernel(); // warm up (page in the arrays)
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int p = 0; p < passes; ++p)
+        kernel();
+    auto end = std::chrono::high_resolution_clock::now();
+
+    double seconds = std::chrono::duration<double>(end - start).count() / passes;
+    double gigabytes = static_cast<double>(bytesPerVector) * count / 1e9;
+    std::cout << "  " << label << ": " << seconds * 1e3 << " ms/pass, " << gigabytes / seconds << " GB/s" << std::endl;
+}
 
-    // Scalar division (handles divide-by-zero case)
-    Vector3 operator/(float scalar) const 
-    {
-        if (scalar == 0) throw std::runtime_error("Division by zero is not allowed");
-        return Vector3(x / scalar, y / scalar, z / scalar);
+void runBatchBenchmarks()
+{
+    const std::size_t count = 1 << 20; // ~1M vectors, 12 MB per array so we are well outside the caches
+    const int passes = 20;
+
+    Vector3Array a(count), b(count), out(count);
+    std::vector<float> scalars(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        a.set(i, Vector3(static_cast<float>(i % 97), 1.0f, 2.0f));
+        b.set(i, Vector3(0.5f, static_cast<float>(i % 13), -1.0f));
     }
+    const Matrix3x4 m = { { 0, -1, 0, 1 }, { 1, 0, 0, 2 }, { 0, 0, 1, 3 } };
+
+#ifdef MATH_USE_AVX2
+    std::cout << std::endl << "Batch benchmark (" << count << " vectors, AVX2)" << std::endl;
+#else
+    std::cout << std::endl << "Batch benchmark (" << count << " vectors, scalar loops)" << std::endl;
+#endif
+    const std::size_t v = 3 * sizeof(float);
+    benchmarkBatchKernel("add      ", 3 * v, count, passes, [&] { Vector3Batch::add(a, b, out); });
+    benchmarkBatchKernel("scale    ", 2 * v, count, passes, [&] { Vector3Batch::scale(a, 2.0f, out); });
+    benchmarkBatchKernel("dot      ", 2 * v + sizeof(float), count, passes, [&] { Vector3Batch::dot(a, b, scalars.data()); });
+    benchmarkBatchKernel("cross    ", 3 * v, count, passes, [&] { Vector3Batch::cross(a, b, out); });
+    benchmarkBatchKernel("length   ", v + sizeof(float), count, passes, [&] { Vector3Batch::length(a, scalars.data()); });
+    benchmarkBatchKernel("normalize", 2 * v, count, passes, [&] { Vector3Batch::normalize(a, out); });
+    benchmarkBatchKernel("transform", 2 * v, count, passes, [&] { Vector3Batch::transform(m, a, out); });
+
+    // the same add done one Vector3 at a time through get/set, for comparison
+    benchmarkBatchKernel("add (one Vector3 at a time)", 3 * v, count, passes / 4, [&] {
+        for (std::size_t i = 0; i < count; ++i)
+            out.set(i, a.get(i) + b.get(i));
+    });
+}
+
+// Measures how far normalized() and operator/ of a precision policy are from a double precision reference
+// over a million random vectors spanning several orders of magnitude, and how long they take
+template <typename Precision>
+void reportPrecisionPolicy(const char* label)
+{
+    typedef BasicVector3<Precision> Vec;
+    const int count = 1000000;
 
-    // Dot product of two vectors
-    // Sum of the products of the corresponding elements x,y,z
-    float dot(const Vector3& other) const 
-    {
-        return x * other.x + y * other.y + z * other.z;
+    std::mt19937 random(1234);
+    std::uniform_real_distribution<float> component(-1.0f, 1.0f);
+    std::uniform_real_distribution<float> exponent(-6.0f, 6.0f);
+    std::vector<Vec> vectors;
+    std::vector<float> divisors;
+    vectors.reserve(count);
+    divisors.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        float magnitude = std::pow(10.0f, exponent(random));
+        vectors.push_back(Vec(component(random), component(random), component(random) + 2.0f) * magnitude);
+        divisors.push_back(std::pow(10.0f, exponent(random)) * (component(random) < 0 ? -1.0f : 1.0f));
     }
 
-    // Cross product of two vectors
-    // using matrix notation and determinants
-    Vector3 cross(const Vector3& other) const 
-    {
-        return Vector3(
-            y * other.z - z * other.y, // x
-            z * other.x - x * other.z, // y
-            x * other.y - y * other.x  // z
-        );
+    // accuracy: worst relative error of any component, measured against the length of the exact result
+    double normalizeError = 0, divideError = 0;
+    for (int i = 0; i < count; ++i) {
+        const Vec& v = vectors[i];
+        double x = v.getX(), y = v.getY(), z = v.getZ();
+        double len = std::sqrt(x * x + y * y + z * z);
+        Vec n = v.normalized();
+        normalizeError = std::max(normalizeError, std::fabs(n.getX() - x / len));
+        normalizeError = std::max(normalizeError, std::fabs(n.getY() - y / len));
+        normalizeError = std::max(normalizeError, std::fabs(n.getZ() - z / len));
+
+        double d = divisors[i];
+        Vec q = v / divisors[i];
+        double qLen = len / std::fabs(d);
+        divideError = std::max(divideError, std::fabs(q.getX() - x / d) / qLen);
+        divideError = std::max(divideError, std::fabs(q.getY() - y / d) / qLen);
+        divideError = std::max(divideError, std::fabs(q.getZ() - z / d) / qLen);
     }
 
-    // print to console the provided vector3
-    void print() const {
-        std::cout << "(" << x << ", " << y << ", " << z << ")" << std::endl;
+    // speed: normalize and divide every vector
+    float checksum = 0;
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < count; ++i) {
+        Vec n = vectors[i].normalized() + vectors[i] / divisors[i];
+        checksum += n.getX();
     }
-};
+    auto end = std::chrono::high_resolution_clock::now();
+    double ns = std::chrono::duration<double, std::nano>(end - start).count() / count;
+
+    std::cout << "  " << label << ": max normalize error " << normalizeError << " (" << -std::log2(normalizeError) << " bits)"
+              << ", max divide error " << divideError << " (" << -std::log2(std::max(divideError, 1e-30)) << " bits)"
+              << ", " << ns << " ns per normalize + divide (checksum " << checksum << ")" << std::endl;
+}
+
+void runPrecisionReport()
+{
+    std::cout << std::endl << "Precision policies (1M random vectors, errors relative to a double precision reference)" << std::endl;
+    reportPrecisionPolicy<Precision::Exact>("Exact    ");
+    reportPrecisionPolicy<Precision::Unchecked>("Unchecked");
+    reportPrecisionPolicy<Precision::Fast>("Fast     ");
+}
 
 int main()
 {
@@ -85,4 +236,49 @@ int main()
     std::cout << "Divided: "; divided.print();
     std::cout << "Dot Product: " << dotProduct << std::endl;
     std::cout << "Cross Product: "; crossProduct.print();
+    std::cout << "Length of v1: " << v1.length() << std::endl;
+    std::cout << "Normalized v1: "; v1.normalized().print();
+
+    // the same vector with approximate math: no divide-by-zero check and an rsqrt based normalize
+    BasicVector3<Precision::Fast> fastV1 = v1;
+    std::cout << "Normalized v1 (Fast): "; fastV1.normalized().print();
+
+    // Whole expressions are evaluated in one pass, without a temporary per operator
+    Vector3 combined = v1 + v2 * 0.5f - crossProduct / 3;
+    std::cout << "v1 + v2 * 0.5 - cross / 3: "; combined.print();
+
+    // an expression kept in auto copies its operands, so it outlives the temporary Vector3(4, 5, 6)
+    auto deferred = Vector3(4, 5, 6) + v2;
+    Vector3 fromDeferred = deferred;
+    Vector3 expected(4 + v2.getX(), 5 + v2.getY(), 6 + v2.getZ());
+    if (fromDeferred.getX() != expected.getX() || fromDeferred.getY() != expected.getY() || fromDeferred.getZ() != expected.getZ()) {
+        std::cout << "Expression kept in auto evaluated wrongly: "; fromDeferred.print();
+        return 1;
+    }
+
+#ifndef MATH_USE_SIMD
+    // in the scalar build the same expressions can be evaluated at compile time
+    constexpr Vector3 compileTime = Vector3(1, 2, 3) + Vector3(4, 5, 6) * 2.0f;
+    static_assert(compileTime.getX() == 9 && compileTime.getY() == 12 && compileTime.getZ() == 15, "constexpr evaluation");
+    constexpr auto compileTimeExpression = Vector3(1, 2, 3) - Vector3(4, 5, 6);
+    static_assert(Vector3(compileTimeExpression).getX() == -3, "constexpr expression kept in auto");
+#endif
+
+    // Batch operations on a structure of arrays
+    Vector3Array positions(3);
+    Vector3Array velocities(3);
+    for (std::size_t i = 0; i < positions.size(); ++i) {
+        positions.set(i, Vector3(static_cast<float>(i), 0, 0));
+        velocities.set(i, Vector3(0, 1, static_cast<float>(i)));
+    }
+    Vector3Batch::scale(velocities, 0.5f, velocities);
+    Vector3Batch::add(positions, velocities, positions);
+    std::cout << "Batch positions after one step:" << std::endl;
+    for (std::size_t i = 0; i < positions.size(); ++i) {
+        std::cout << "  "; positions.get(i).print();
+    }
+
+    runBenchmarks();
+    runBatchBenchmarks();
+    runPrecisionReport();
 }
@@ -0,0 +1,285 @@
+// Contiguous height field storage for the ABC / ACD triangulated mesh from Question5&6.cpp
+//
+// vector<vector<double>> allocates every row separately, so the four corners of a cell (A, B, C, D) always live in
+// two unrelated heap blocks. HeightField keeps every sample in one aligned buffer, and the Layout parameter decides
+// how (x, y) maps into that buffer:
+//   RowMajorLayout  - x * sizeY + y, the same order as heightMap[x][y] but without the per-row allocations
+//   TiledLayout<N>  - N x N blocks stored one after another, a 4x4 float tile is exactly one 64 byte cache line,
+//                     so 9 out of 16 cells have all four corners in a single line (and the rest in two)
+//   MortonLayout    - Z-order curve (interleaved x/y bits), keeps neighbours close at every scale
+// The sample type T is float or double. RowMajorLayout is the default: for single random queries it is the fastest
+// (the tiled layouts touch fewer cache lines but pay for the index math); Tiled and Morton win in the 8 wide batch
+// queries of HeightFieldBatch.h.
+
+#pragma once
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <stdexcept>
+
+#include "../MathLibrary/MathConfig.h"
+
+// std::vector allocator that aligns the buffer to Alignment bytes (a cache line by default)
+template <typename T, std::size_t Alignment = 64>
+struct AlignedAllocator {
+    typedef T value_type;
+
+    template <typename U> struct rebind { typedef AlignedAllocator<U, Alignment> other; };
+
+    AlignedAllocator() = default;
+    template <typename U> AlignedAllocator(const AlignedAllocator<U, Alignment>&) {}
+
+    T* allocate(std::size_t n) {
+        return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t(Alignment)));
+    }
+
+    void deallocate(T* p, std::size_t) {
+        ::operator delete(p, std::align_val_t(Alignment));
+    }
+
+    bool operator==(const AlignedAllocator&) const { return true; }
+    bool operator!=(const AlignedAllocator&) const { return false; }
+};
+
+
+// x * sizeY + y, i.e. the same order as the original heightMap[x][y]
+class RowMajorLayout {
+private:
+    std::size_t sizeY;
+    std::size_t size;
+
+public:
+    RowMajorLayout(std::size_t sizeX, std::size_t sizeY) : sizeY(sizeY), size(sizeX * sizeY) {}
+
+    std::size_t index(std::size_t x, std::size_t y) const { return x * sizeY + y; }
+    std::size_t storageSize() const { return size; }
+
+    // indices of the corners A (x, y), B (x+1, y), C (x+1, y+1) and D (x, y+1) of the cell at (x, y)
+    void cellCorners(std::size_t x, std::size_t y, std::size_t corners[4]) const {
+        corners[0] = index(x, y);
+        corners[1] = corners[0] + sizeY;
+        corners[2] = corners[1] + 1;
+        corners[3] = corners[0] + 1;
+    }
+
+#ifdef MATH_USE_AVX2
+    // index() for 8 points at once (32 bit lanes, the caller checks that storageSize() fits)
+    __m256i index8(__m256i x, __m256i y) const {
+        return _mm256_add_epi32(_mm256_mullo_epi32(x, _mm256_set1_epi32(static_cast<int>(sizeY))), y);
+    }
+#endif
+};
+
+// TileSize x TileSize blocks, each stored contiguously (x-major inside the tile, tiles x-major as well)
+// the grid is padded up to a whole number of tiles
+template <std::size_t TileSize = 4>
+class TiledLayout {
+private:
+    std::size_t tilesY;
+    std::size_t size;
+
+public:
+    TiledLayout(std::size_t sizeX, std::size_t sizeY)
+        : tilesY((sizeY + TileSize - 1) / TileSize), size(((sizeX + TileSize - 1) / TileSize) * tilesY * TileSize * TileSize) {}
+
+    std::size_t index(std::size_t x, std::size_t y) const {
+        std::size_t tile = (x / TileSize) * tilesY + (y / TileSize);
+        return tile * (TileSize * TileSize) + (x % TileSize) * TileSize + (y % TileSize);
+    }
+
+    std::size_t storageSize() const { return size; }
+
+    // indices of the corners A (x, y), B (x+1, y), C (x+1, y+1) and D (x, y+1) of the cell at (x, y)
+    void cellCorners(std::size_t x, std::size_t y, std::size_t corners[4]) const {
+        corners[0] = index(x, y);
+        corners[1] = index(x + 1, y);
+        corners[2] = index(x + 1, y + 1);
+        corners[3] = index(x, y + 1);
+    }
+
+#ifdef MATH_USE_AVX2
+    // index() for 8 points at once (32 bit lanes, the caller checks that storageSize() fits)
+    // the divisions and remainders become shifts and masks, so the tile size has to be a power of two here
+    __m256i index8(__m256i x, __m256i y) const {
+        static_assert((TileSize & (TileSize - 1)) == 0, "8-wide indexing needs a power of two tile size");
+        const int shift = tileShift();
+        const __m256i mask = _mm256_set1_epi32(static_cast<int>(TileSize - 1));
+        __m256i tile = _mm256_add_epi32(_mm256_mullo_epi32(_mm256_srli_epi32(x, shift), _mm256_set1_epi32(static_cast<int>(tilesY))),
+                                        _mm256_srli_epi32(y, shift));
+        __m256i inTile = _mm256_add_epi32(_mm256_slli_epi32(_mm256_and_si256(x, mask), shift), _mm256_and_si256(y, mask));
+        return _mm256_add_epi32(_mm256_slli_epi32(tile, 2 * shift), inTile);
+    }
+
+private:
+    static int tileShift() {
+        int shift = 0;
+        while ((std::size_t(1) << shift) < TileSize) ++shift;
+        return shift;
+    }
+#endif
+};
+
+// Z-order curve: the bits of x and y are interleaved (x in the even bits, y in the odd bits)
+// storage is sized for the largest index actually used, so square power-of-two grids waste nothing
+class MortonLayout {
+private:
+    std::size_t size;
+
+    static constexpr std::uint64_t xBits = 0x5555555555555555ull;
+    static constexpr std::uint64_t yBits = 0xaaaaaaaaaaaaaaaaull;
+
+    // index of (x + 1, y) / (x, y + 1) straight from the index of (x, y): filling the other coordinate's bits with ones
+    // makes the carry of the + 1 ripple through only this coordinate's bits
+    static std::uint64_t incrementX(std::uint64_t m) { return (((m | yBits) + 1) & xBits) | (m & yBits); }
+    static std::uint64_t incrementY(std::uint64_t m) { return (((m | xBits) + 1) & yBits) | (m & xBits); }
+
+    // spreads the lower 32 bits of v out to the even bits of the result
+    static std::uint64_t spreadBits(std::uint64_t v) {
+        v &= 0xffffffffull;
+        v = (v | (v << 16)) & 0x0000ffff0000ffffull;
+        v = (v | (v << 8)) & 0x00ff00ff00ff00ffull;
+        v = (v | (v << 4)) & 0x0f0f0f0f0f0f0f0full;
+        v = (v | (v << 2)) & 0x3333333333333333ull;
+        v = (v | (v << 1)) & 0x5555555555555555ull;
+        return v;
+    }
+
+public:
+    MortonLayout(std::size_t sizeX, std::size_t sizeY)
+        : size(sizeX && sizeY ? static_cast<std::size_t>(spreadBits(sizeX - 1) | (spreadBits(sizeY - 1) << 1)) + 1 : 0) {}
+
+    std::size_t index(std::size_t x, std::size_t y) const {
+        return static_cast<std::size_t>(spreadBits(x) | (spreadBits(y) << 1));
+    }
+
+    std::size_t storageSize() const { return size; }
+
+    // indices of the corners A (x, y), B (x+1, y), C (x+1, y+1) and D (x, y+1) of the cell at (x, y)
+    void cellCorners(std::size_t x, std::size_t y, std::size_t corners[4]) const {
+        std::uint64_t a = spreadBits(x) | (spreadBits(y) << 1);
+        std::uint64_t b = incrementX(a);
+        corners[0] = static_cast<std::size_t>(a);
+        corners[1] = static_cast<std::size_t>(b);
+        corners[2] = static_cast<std::size_t>(incrementY(b));
+        corners[3] = static_cast<std::size_t>(incrementY(a));
+    }
+
+#ifdef MATH_USE_AVX2
+    // index() for 8 points at once (32 bit lanes, so x and y below 65536 and the caller checks that storageSize() fits)
+    __m256i index8(__m256i x, __m256i y) const {
+        return _mm256_or_si256(spreadBits8(x), _mm256_slli_epi32(spreadBits8(y), 1));
+    }
+
+private:
+    static __m256i spreadBits8(__m256i v) {
+        v = _mm256_and_si256(_mm256_or_si256(v, _mm256_slli_epi32(v, 8)), _mm256_set1_epi32(0x00ff00ff));
+        v = _mm256_and_si256(_mm256_or_si256(v, _mm256_slli_epi32(v, 4)), _mm256_set1_epi32(0x0f0f0f0f));
+        v = _mm256_and_si256(_mm256_or_si256(v, _mm256_slli_epi32(v, 2)), _mm256_set1_epi32(0x33333333));
+        v = _mm256_and_si256(_mm256_or_si256(v, _mm256_slli_epi32(v, 1)), _mm256_set1_epi32(0x55555555));
+        return v;
+    }
+#endif
+};
+
+
+template <typename T, typename Layout = RowMajorLayout>
+class HeightField {
+private:
+    std::size_t sizeX;
+    std::size_t sizeY;
+    Layout layout;
+    std::vector<T, AlignedAllocator<T>> samples;
+
+public:
+    typedef T SampleType;
+
+    // creates a sizeX by sizeY grid filled with initialHeight
+    HeightField(std::size_t sizeX, std::size_t sizeY, T initialHeight = T())
+        : sizeX(sizeX), sizeY(sizeY), layout(sizeX, sizeY), samples(layout.storageSize(), initialHeight) {}
+
+    // converts the original vector<vector<double>> format, heightMap[x][y]
+    explicit HeightField(const std::vector<std::vector<double>>& heightMap)
+        : HeightField(heightMap.size(), heightMap.empty() ? 0 : heightMap[0].size()) {
+        for (std::size_t x = 0; x < sizeX; ++x) {
+            if (heightMap[x].size() != sizeY)
+                throw std::invalid_argument("Height map rows must all have the same length.");
+            for (std::size_t y = 0; y < sizeY; ++y)
+                samples[layout.index(x, y)] = static_cast<T>(heightMap[x][y]);
+        }
+    }
+
+    std::size_t getSizeX() const { return sizeX; }
+    std::size_t getSizeY() const { return sizeY; }
+
+    // bytes used by the sample buffer (including any layout padding)
+    std::size_t memoryUsage() const { return samples.size() * sizeof(T); }
+
+    // raw access to the buffer and the mapping into it, for batch / streaming code built on top of HeightField
+    const Layout& getLayout() const { return layout; }
+    const T* data() const { return samples.data(); }
+
+    // read / write a single sample (with bounds checking)
+    T get(std::size_t x, std::size_t y) const {
+        if (x >= sizeX || y >= sizeY)
+            throw std::out_of_range("Sample is outside the height map bounds.");
+        return samples[layout.index(x, y)];
+    }
+
+    void set(std::size_t x, std::size_t y, T height) {
+        if (x >= sizeX || y >= sizeY)
+            throw std::out_of_range("Sample is outside the height map bounds.");
+        samples[layout.index(x, y)] = height;
+    }
+
+    // unchecked sample access, for callers that have already validated the cell
+    T sample(std::size_t x, std::size_t y) const {
+        return samples[layout.index(x, y)];
+    }
+
+    // heights of the corners A, B, C and D of the cell at (x, y) (unchecked), the interface the ray queries read through
+    void getCellHeights(std::size_t x, std::size_t y, double heights[4]) const {
+        std::size_t corners[4];
+        layout.cellCorners(x, y, corners);
+        for (int i = 0; i < 4; ++i)
+            heights[i] = samples[corners[i]];
+    }
+
+    // Exact height at (x, y), same triangulation and barycentric weights as the free getExactHeight function
+    double getExactHeight(double x, double y) const {
+        int Ax = static_cast<int>(x);
+        int Ay = static_cast<int>(y);
+
+        // Ensure we don't go out of bounds
+        if (Ax < 0 || Ay < 0 || static_cast<std::size_t>(Ax) + 1 >= sizeX || static_cast<std::size_t>(Ay) + 1 >= sizeY) {
+            throw std::out_of_range("Point is outside the height map bounds.");
+        }
+
+        // Define the four corners of the grid square
+        std::size_t corners[4];
+        layout.cellCorners(Ax, Ay, corners);
+        double Ha = samples[corners[0]];     // A (Bottom-left)
+        double Hb = samples[corners[1]];     // B (Bottom-right)
+        double Hc = samples[corners[2]];     // C (Top-right)
+        double Hd = samples[corners[3]];     // D (Top-left)
+
+        // Local coordinates inside the grid cell
+        double dx = x - Ax;
+        double dy = y - Ay;
+
+        // Determine which triangle (ABC or ACD)
+        if (dx >= dy) {
+            return (1 - dx) * Ha + (dx - dy) * Hb + dy * Hc;   // Triangle ABC
+        }
+        else {
+            return (1 - dy) * Ha + dx * Hc + (dy - dx) * Hd;   // Triangle ACD
+        }
+    }
+};
+
+// Same call shape as the original getExactHeight(heightMap, x, y)
+template <typename T, typename Layout>
+double getExactHeight(const HeightField<T, Layout>& heightField, double x, double y) {
+    return heightField.getExactHeight(x, y);
+}
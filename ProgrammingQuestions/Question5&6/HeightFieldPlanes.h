@@ -0,0 +1,136 @@
+// Optional acceleration cache of the plane of every triangle of a HeightField, for height / normal / slope queries
+//
+// Both triangles of a cell are planes through A, so each is height = Ha + gx * dx + gy * dy with
+//   ABC: gx = Hb - Ha, gy = Hc - Hb        ACD: gx = Hc - Hd, gy = Hd - Ha
+// The cache stores Ha, (gx, gy) of both triangles and 1 / |(-gx, -gy, 1)|, 32 bytes per cell (so two cells per cache
+// line and no cell split across lines). A height query is then one select and two multiply-adds, the slope is the
+// stored gradient and the unit normal (-gx, -gy, 1) * inverseLength needs no square root.
+// It costs 8x the memory of a float HeightField, so it is meant for the areas / maps that are queried heavily.
+
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+
+#include "../MathLibrary/Vector2.h"
+#include "../MathLibrary/Vector3.h"
+#include "HeightField.h"
+
+// The cache keeps a pointer to its height field, so the field has to outlive it (and must not be moved)
+template <typename T, typename Layout = RowMajorLayout>
+class HeightFieldPlaneCache {
+private:
+    // one cell, the two gradients are laid out the same way so a triangle is picked with a single offset
+    struct alignas(32) CellPlanes {
+        float height;              // Ha
+        float padding;
+        float triangles[2][3];     // [ABC, ACD] x (gx, gy, inverseLength)
+    };
+
+    const HeightField<T, Layout>* heightField;
+    std::size_t cellsX = 0;
+    std::size_t cellsY = 0;
+    std::vector<CellPlanes, AlignedAllocator<CellPlanes>> cells;
+
+    void buildCell(std::size_t x, std::size_t y) {
+        std::size_t corners[4];
+        heightField->getLayout().cellCorners(x, y, corners);
+        const T* samples = heightField->data();
+        float Ha = static_cast<float>(samples[corners[0]]), Hb = static_cast<float>(samples[corners[1]]);
+        float Hc = static_cast<float>(samples[corners[2]]), Hd = static_cast<float>(samples[corners[3]]);
+
+        CellPlanes& cell = cells[x * cellsY + y];
+        float gradients[2][2] = { { Hb - Ha, Hc - Hb }, { Hc - Hd, Hd - Ha } };
+        cell.height = Ha;
+        cell.padding = 0;
+        for (int triangle = 0; triangle < 2; ++triangle) {
+            float gx = gradients[triangle][0], gy = gradients[triangle][1];
+            cell.triangles[triangle][0] = gx;
+            cell.triangles[triangle][1] = gy;
+            cell.triangles[triangle][2] = 1.0f / std::sqrt(gx * gx + gy * gy + 1.0f);
+        }
+    }
+
+    // finds the cell and triangle under (x, y), with the same bounds check as getExactHeight
+    const float* lookup(float x, float y, float& dx, float& dy, float& height) const {
+        int Ax = static_cast<int>(x);
+        int Ay = static_cast<int>(y);
+
+        // Ensure we don't go out of bounds
+        if (Ax < 0 || Ay < 0 || static_cast<std::size_t>(Ax) >= cellsX || static_cast<std::size_t>(Ay) >= cellsY) {
+            throw std::out_of_range("Point is outside the height map bounds.");
+        }
+
+        const CellPlanes& cell = cells[Ax * cellsY + Ay];
+        dx = x - Ax;
+        dy = y - Ay;
+        height = cell.height;
+        return cell.triangles[dx >= dy ? 0 : 1];   // Triangle ABC or ACD
+    }
+
+public:
+    explicit HeightFieldPlaneCache(const HeightField<T, Layout>& heightField) : heightField(&heightField) {
+        if (heightField.getSizeX() < 2 || heightField.getSizeY() < 2) return;
+
+        cellsX = heightField.getSizeX() - 1;
+        cellsY = heightField.getSizeY() - 1;
+        cells.resize(cellsX * cellsY);
+        for (std::size_t x = 0; x < cellsX; ++x)
+            for (std::size_t y = 0; y < cellsY; ++y)
+                buildCell(x, y);
+    }
+
+    const HeightField<T, Layout>& getHeightField() const { return *heightField; }
+
+    // bytes used by the cached planes
+    std::size_t memoryUsage() const { return cells.size() * sizeof(CellPlanes); }
+
+    // Same height as getExactHeight(heightField, x, y), in float precision
+    float getExactHeight(float x, float y) const {
+        float dx, dy, height;
+        const float* plane = lookup(x, y, dx, dy, height);
+        return height + plane[0] * dx + plane[1] * dy;
+    }
+
+    // unit surface normal of the triangle under (x, y), pointing up
+    Vector3 getNormal(float x, float y) const {
+        float dx, dy, height;
+        const float* plane = lookup(x, y, dx, dy, height);
+        return Vector3(-plane[0] * plane[2], -plane[1] * plane[2], plane[2]);
+    }
+
+    // height change per unit of x and per unit of y on the triangle under (x, y)
+    Vector2 getGradient(float x, float y) const {
+        float dx, dy, height;
+        const float* plane = lookup(x, y, dx, dy, height);
+        return Vector2(plane[0], plane[1]);
+    }
+
+    // steepness as rise over run (0 is flat, 1 is 45 degrees)
+    float getSlope(float x, float y) const {
+        return getGradient(x, y).length();
+    }
+
+    // height and normal from a single lookup, for movement code that needs both
+    float getHeightAndNormal(float x, float y, Vector3& normal) const {
+        float dx, dy, height;
+        const float* plane = lookup(x, y, dx, dy, height);
+        normal = Vector3(-plane[0] * plane[2], -plane[1] * plane[2], plane[2]);
+        return height + plane[0] * dx + plane[1] * dy;
+    }
+
+    // Call after the samples [x0, x1] x [y0, y1] (inclusive) of the height field were changed, rebuilds only the cells
+    // that use those samples
+    void update(std::size_t x0, std::size_t y0, std::size_t x1, std::size_t y1) {
+        if (cells.empty() || x0 > x1 || y0 > y1 || x1 >= heightField->getSizeX() || y1 >= heightField->getSizeY())
+            throw std::out_of_range("Region is outside the height map bounds.");
+
+        // a sample is a corner of the cells on both sides of it
+        for (std::size_t x = x0 > 0 ? x0 - 1 : 0; x <= std::min(x1, cellsX - 1); ++x)
+            for (std::size_t y = y0 > 0 ? y0 - 1 : 0; y <= std::min(y1, cellsY - 1); ++y)
+                buildCell(x, y);
+    }
+};
@@ -0,0 +1,235 @@
+// Min / max pyramid (quadtree) over the cells of a HeightField, for queries that would otherwise visit every cell
+//
+// Level 0 is the cells themselves: the lowest and highest corner of a cell are exactly the lowest and highest point of
+// the mesh inside it (the mesh is flat triangles), so level 0 is read straight from the height field instead of being
+// stored. Every level above halves the resolution, so a node at level k covers a block of 2^k x 2^k cells and all
+// stored levels together take 8 / 3 bytes per float sample. Queries use it two ways:
+//   getHeightRange / getMaxHeight / getMinHeight - a region is answered by the few largest nodes that fit inside it
+//   raycast(pyramid, ...)                        - blocks the ray passes over are skipped whole, and the walk only
+//                                                  drops down to single cells where the ray gets close to the ground
+// After editing heights, update() rebuilds only the nodes above the edited samples.
+
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+#include "../MathLibrary/Vector3.h"
+#include "HeightField.h"
+#include "HeightFieldRay.h"
+
+// The pyramid keeps a pointer to its height field, so the field has to outlive it (and must not be moved)
+template <typename T, typename Layout = RowMajorLayout>
+class HeightFieldPyramid {
+public:
+    struct Range {
+        T minHeight;
+        T maxHeight;
+    };
+
+private:
+    struct Level {
+        std::size_t sizeX;
+        std::size_t sizeY;
+        std::size_t offset;   // first node of this level in nodes
+    };
+
+    const HeightField<T, Layout>* heightField;
+    std::vector<Level> levels;   // levels[0] is the cells (not stored), levels[k] is stored from nodes[levels[k].offset]
+    std::vector<Range> nodes;
+
+    Range& node(int level, std::size_t x, std::size_t y) {
+        return nodes[levels[level].offset + x * levels[level].sizeY + y];
+    }
+
+    Range cellRange(std::size_t x, std::size_t y) const {
+        std::size_t corners[4];
+        heightField->getLayout().cellCorners(x, y, corners);
+        const T* samples = heightField->data();
+        T Ha = samples[corners[0]], Hb = samples[corners[1]], Hc = samples[corners[2]], Hd = samples[corners[3]];
+        return Range{ std::min(std::min(Ha, Hb), std::min(Hc, Hd)), std::max(std::max(Ha, Hb), std::max(Hc, Hd)) };
+    }
+
+    // combine the (up to) four children of a node, blocks on the far edges may have only one or two
+    void buildNode(int level, std::size_t x, std::size_t y) {
+        const Level& children = levels[level - 1];
+        Range range = getRange(level - 1, 2 * x, 2 * y);
+        for (std::size_t cx = 2 * x; cx <= 2 * x + 1 && cx < children.sizeX; ++cx) {
+            for (std::size_t cy = 2 * y; cy <= 2 * y + 1 && cy < children.sizeY; ++cy) {
+                Range child = getRange(level - 1, cx, cy);
+                range.minHeight = std::min(range.minHeight, child.minHeight);
+                range.maxHeight = std::max(range.maxHeight, child.maxHeight);
+            }
+        }
+        node(level, x, y) = range;
+    }
+
+    // rebuilds every node above cells [x0, x1] x [y0, y1]
+    void rebuild(std::size_t x0, std::size_t y0, std::size_t x1, std::size_t y1) {
+        for (int level = 1; level < getLevelCount(); ++level) {
+            x0 >>= 1; y0 >>= 1; x1 >>= 1; y1 >>= 1;
+            for (std::size_t x = x0; x <= x1; ++x)
+                for (std::size_t y = y0; y <= y1; ++y)
+                    buildNode(level, x, y);
+        }
+    }
+
+    // adds the nodes of the subtree at (level, x, y) that lie inside cells [x0, x1] x [y0, y1] to result
+    void queryRange(int level, std::size_t x, std::size_t y, std::size_t x0, std::size_t y0, std::size_t x1, std::size_t y1, Range& result) const {
+        std::size_t blockX0 = x << level, blockY0 = y << level;
+        std::size_t blockX1 = ((x + 1) << level) - 1, blockY1 = ((y + 1) << level) - 1;
+        if (blockX0 > x1 || blockX1 < x0 || blockY0 > y1 || blockY1 < y0) return;
+
+        // a block inside the region counts whole (single cells always are), and a partly covered block whose range is
+        // already inside the result cannot change it
+        Range range = getRange(level, x, y);
+        if (blockX0 >= x0 && blockX1 <= x1 && blockY0 >= y0 && blockY1 <= y1) {
+            result.minHeight = std::min(result.minHeight, range.minHeight);
+            result.maxHeight = std::max(result.maxHeight, range.maxHeight);
+            return;
+        }
+        if (range.minHeight >= result.minHeight && range.maxHeight <= result.maxHeight) return;
+
+        // children the region covers completely first, they widen the result and let more of the partial ones be skipped
+        const Level& children = levels[level - 1];
+        std::size_t childX1 = std::min(2 * x + 1, children.sizeX - 1), childY1 = std::min(2 * y + 1, children.sizeY - 1);
+        std::size_t size = std::size_t(1) << (level - 1);
+        for (int pass = 0; pass < 2; ++pass) {
+            for (std::size_t cx = 2 * x; cx <= childX1; ++cx) {
+                for (std::size_t cy = 2 * y; cy <= childY1; ++cy) {
+                    bool childInside = cx * size >= x0 && (cx + 1) * size - 1 <= x1 && cy * size >= y0 && (cy + 1) * size - 1 <= y1;
+                    if (childInside == (pass == 0))
+                        queryRange(level - 1, cx, cy, x0, y0, x1, y1, result);
+                }
+            }
+        }
+    }
+
+    Range query(std::size_t x0, std::size_t y0, std::size_t x1, std::size_t y1, Range result) const {
+        if (levels.empty() || x0 > x1 || y0 > y1 || x1 >= levels[0].sizeX || y1 >= levels[0].sizeY)
+            throw std::out_of_range("Region is outside the height map bounds.");
+
+        queryRange(getLevelCount() - 1, 0, 0, x0, y0, x1, y1, result);
+        return result;
+    }
+
+public:
+    // builds every level from the samples of heightField (O(number of samples))
+    explicit HeightFieldPyramid(const HeightField<T, Layout>& heightField) : heightField(&heightField) {
+        if (heightField.getSizeX() < 2 || heightField.getSizeY() < 2) return;
+
+        std::size_t sizeX = heightField.getSizeX() - 1, sizeY = heightField.getSizeY() - 1, offset = 0;
+        levels.push_back(Level{ sizeX, sizeY, 0 });
+        while (sizeX > 1 || sizeY > 1) {
+            sizeX = (sizeX + 1) / 2;
+            sizeY = (sizeY + 1) / 2;
+            levels.push_back(Level{ sizeX, sizeY, offset });
+            offset += sizeX * sizeY;
+        }
+        nodes.resize(offset);
+        rebuild(0, 0, levels[0].sizeX - 1, levels[0].sizeY - 1);
+    }
+
+    const HeightField<T, Layout>& getHeightField() const { return *heightField; }
+
+    int getLevelCount() const { return static_cast<int>(levels.size()); }
+    std::size_t getLevelSizeX(int level) const { return levels[level].sizeX; }
+    std::size_t getLevelSizeY(int level) const { return levels[level].sizeY; }
+
+    // bytes used by the stored levels (about a third of level 0, which is not stored)
+    std::size_t memoryUsage() const { return nodes.size() * sizeof(Range); }
+
+    // lowest / highest mesh height in the 2^level x 2^level block of cells at (x, y) (unchecked)
+    Range getRange(int level, std::size_t x, std::size_t y) const {
+        if (level == 0) return cellRange(x, y);
+        return nodes[levels[level].offset + x * levels[level].sizeY + y];
+    }
+
+    // Lowest and highest mesh height over cells [cellX0, cellX1] x [cellY0, cellY1] (inclusive), i.e. over the
+    // samples [cellX0, cellX1 + 1] x [cellY0, cellY1 + 1]
+    Range getHeightRange(std::size_t cellX0, std::size_t cellY0, std::size_t cellX1, std::size_t cellY1) const {
+        return query(cellX0, cellY0, cellX1, cellY1, Range{ std::numeric_limits<T>::max(), std::numeric_limits<T>::lowest() });
+    }
+
+    // starting the unused side at its far end means it never stops a block from being skipped
+    T getMaxHeight(std::size_t cellX0, std::size_t cellY0, std::size_t cellX1, std::size_t cellY1) const {
+        return query(cellX0, cellY0, cellX1, cellY1, Range{ std::numeric_limits<T>::lowest(), std::numeric_limits<T>::lowest() }).maxHeight;
+    }
+
+    T getMinHeight(std::size_t cellX0, std::size_t cellY0, std::size_t cellX1, std::size_t cellY1) const {
+        return query(cellX0, cellY0, cellX1, cellY1, Range{ std::numeric_limits<T>::max(), std::numeric_limits<T>::max() }).minHeight;
+    }
+
+    // Call after the samples [x0, x1] x [y0, y1] (inclusive) of the height field were changed, rebuilds only the nodes
+    // above the cells that use those samples
+    void update(std::size_t x0, std::size_t y0, std::size_t x1, std::size_t y1) {
+        if (levels.empty() || x0 > x1 || y0 > y1 || x1 >= heightField->getSizeX() || y1 >= heightField->getSizeY())
+            throw std::out_of_range("Region is outside the height map bounds.");
+
+        // a sample is a corner of the cells on both sides of it
+        rebuild(x0 > 0 ? x0 - 1 : 0, y0 > 0 ? y0 - 1 : 0, std::min(x1, levels[0].sizeX - 1), std::min(y1, levels[0].sizeY - 1));
+    }
+};
+
+// Same result as raycast(heightField, ...) on the pyramid's height field, but whole blocks of cells the ray passes over
+// are skipped (the pyramid has to be up to date with the height field)
+template <typename T, typename Layout>
+bool raycast(const HeightFieldPyramid<T, Layout>& pyramid, const Vector3& origin, const Vector3& direction, float maxDistance, HeightFieldHit& hit) {
+    using namespace HeightFieldRay;
+
+    const HeightField<T, Layout>& heightField = pyramid.getHeightField();
+
+    ClippedRay ray;
+    if (!clipRay(heightField, origin, direction, maxDistance, ray)) return false;
+
+    const double infinity = std::numeric_limits<double>::infinity();
+    const int lastCellX = static_cast<int>(heightField.getSizeX()) - 2;
+    const int lastCellY = static_cast<int>(heightField.getSizeY()) - 2;
+    const int topLevel = pyramid.getLevelCount() - 1;
+
+    double t = ray.t;
+    int cellX = std::min(std::max(static_cast<int>(std::floor(ray.ox + t * ray.dirX)), 0), lastCellX);
+    int cellY = std::min(std::max(static_cast<int>(std::floor(ray.oy + t * ray.dirY)), 0), lastCellY);
+    int level = 0;
+
+    while (true) {
+        // the block at this level containing the current cell, and where the ray leaves it
+        int blockX = cellX >> level, blockY = cellY >> level;
+        int blockX0 = blockX << level, blockX1 = (blockX + 1) << level;
+        int blockY0 = blockY << level, blockY1 = (blockY + 1) << level;
+        double tExitX = ray.dirX > 0 ? (blockX1 - ray.ox) / ray.dirX : (ray.dirX < 0 ? (blockX0 - ray.ox) / ray.dirX : infinity);
+        double tExitY = ray.dirY > 0 ? (blockY1 - ray.oy) / ray.dirY : (ray.dirY < 0 ? (blockY0 - ray.oy) / ray.dirY : infinity);
+        double tExit = std::min(std::min(tExitX, tExitY), ray.tEnd);
+
+        double zMin = ray.oz + std::min(t * ray.dirZ, tExit * ray.dirZ);
+        bool above = zMin > pyramid.getRange(level, blockX, blockY).maxHeight;
+        if (!above && level > 0) {
+            // the ray may touch something in this block, look at it in more detail
+            --level;
+            continue;
+        }
+        if (!above && hitCell(heightField, ray, cellX, cellY, t, tExit, hit)) return true;
+
+        // leave the block through whichever side comes first, the other coordinate stays inside the block
+        if (tExit >= ray.tEnd) return false;
+        t = tExit;
+        if (tExitX <= tExitY) {
+            cellX = ray.dirX > 0 ? blockX1 : blockX0 - 1;
+            if (tExitY > tExitX)
+                cellY = std::min(std::max(static_cast<int>(std::floor(ray.oy + t * ray.dirY)), blockY0), std::min(blockY1 - 1, lastCellY));
+        }
+        if (tExitY <= tExitX) {
+            cellY = ray.dirY > 0 ? blockY1 : blockY0 - 1;
+            if (tExitX > tExitY)
+                cellX = std::min(std::max(static_cast<int>(std::floor(ray.ox + t * ray.dirX)), blockX0), std::min(blockX1 - 1, lastCellX));
+        }
+        if (cellX < 0 || cellX > lastCellX || cellY < 0 || cellY > lastCellY) return false;
+
+        // after skipping a block try bigger steps again
+        if (above && level < topLevel) ++level;
+    }
+}
@@ -0,0 +1,186 @@
+// Ray casting against the ABC / ACD triangulated mesh of a HeightField (line of sight, projectile / ground hits)
+//
+// Positions are (x, y, height), the same as getSurfacePoint. The ray is clipped to the grid, then the cells under it
+// are walked in order with a DDA (Amanatides & Woo grid traversal), so a ray only costs the cells it actually crosses.
+// Inside a cell the ray's footprint crosses the diagonal x = y at most once, and on either side of that crossing both
+// the ray height and the mesh height are linear in t. The first sign change of (ray height - mesh height) is therefore
+// found exactly from the two end values of at most two pieces, and the hit agrees with getExactHeight at the hit point.
+
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <algorithm>
+#include <limits>
+
+#include "../MathLibrary/Vector3.h"
+#include "HeightField.h"
+
+struct HeightFieldHit {
+    Vector3 point;     // (x, y, height) of the hit, on the mesh
+    Vector3 normal;    // unit normal of the triangle that was hit, pointing up
+    int cellX = 0;     // cell (x, y) the hit is in, i.e. the A corner
+    int cellY = 0;
+    float distance = 0; // distance from the ray origin to point
+};
+
+namespace HeightFieldRay {
+
+    // Plane of one triangle in cell local coordinates: height = a + bx * dx + by * dy
+    struct CellPlane {
+        double a, bx, by;
+
+        double height(double dx, double dy) const { return a + bx * dx + by * dy; }
+    };
+
+    // ABC: Ha + dx * (Hb - Ha) + dy * (Hc - Hb),   ACD: Ha + dx * (Hc - Hd) + dy * (Hd - Ha)
+    inline CellPlane trianglePlane(double Ha, double Hb, double Hc, double Hd, bool abc) {
+        return abc ? CellPlane{ Ha, Hb - Ha, Hc - Hb } : CellPlane{ Ha, Hc - Hd, Hd - Ha };
+    }
+
+    // Ray against one cell for t in [t0, t1]. ox / oy are the ray origin relative to the A corner
+    // returns the first t where the ray is on or below the mesh, or a negative value if there is none
+    inline double intersectCell(double ox, double oy, double oz, double dirX, double dirY, double dirZ,
+                                double Ha, double Hb, double Hc, double Hd, double t0, double t1, bool& abc) {
+        // split [t0, t1] where the footprint crosses the diagonal (dx - dy changes sign)
+        double pieces[3] = { t0, t1, t1 };
+        int pieceCount = 1;
+        double u0 = ox - oy, du = dirX - dirY;
+        if (du != 0) {
+            double tDiagonal = -u0 / du;
+            if (tDiagonal > t0 && tDiagonal < t1) {
+                pieces[1] = tDiagonal;
+                pieceCount = 2;
+            }
+        }
+
+        for (int piece = 0; piece < pieceCount; ++piece) {
+            double ta = pieces[piece], tb = pieces[piece + 1];
+            double tm = 0.5 * (ta + tb);
+            bool pieceAbc = (ox + tm * dirX) >= (oy + tm * dirY);
+            CellPlane plane = trianglePlane(Ha, Hb, Hc, Hd, pieceAbc);
+
+            // height of the ray above the mesh at both ends of the piece (linear in between)
+            double fa = oz + ta * dirZ - plane.height(ox + ta * dirX, oy + ta * dirY);
+            double fb = oz + tb * dirZ - plane.height(ox + tb * dirX, oy + tb * dirY);
+            if (fa <= 0) {
+                abc = pieceAbc;
+                return ta;
+            }
+            if (fb <= 0) {
+                abc = pieceAbc;
+                return ta + (tb - ta) * fa / (fa - fb);
+            }
+        }
+        return -1;
+    }
+
+    // t range in which origin + t * direction is inside [lo, hi] along one axis, narrows [tMin, tMax]
+    inline bool clipSlab(double origin, double direction, double lo, double hi, double& tMin, double& tMax) {
+        if (direction == 0)
+            return origin >= lo && origin <= hi;
+        double ta = (lo - origin) / direction, tb = (hi - origin) / direction;
+        if (ta > tb) std::swap(ta, tb);
+        tMin = std::max(tMin, ta);
+        tMax = std::min(tMax, tb);
+        return tMin <= tMax;
+    }
+
+    // A ray normalized and clipped to the grid: origin + t * direction for t in [t, tEnd]
+    struct ClippedRay {
+        double ox, oy, oz;
+        double dirX, dirY, dirZ;
+        double t, tEnd;
+    };
+
+    // returns false if the ray has no direction or misses the grid entirely
+    template <typename Field>
+    bool clipRay(const Field& heightField, const Vector3& origin, const Vector3& direction, float maxDistance, ClippedRay& ray) {
+        if (heightField.getSizeX() < 2 || heightField.getSizeY() < 2) return false;
+
+        double dirX = direction.getX(), dirY = direction.getY(), dirZ = direction.getZ();
+        double length = std::sqrt(dirX * dirX + dirY * dirY + dirZ * dirZ);
+        if (length == 0) return false;
+        ray.dirX = dirX / length; ray.dirY = dirY / length; ray.dirZ = dirZ / length;
+        ray.ox = origin.getX(); ray.oy = origin.getY(); ray.oz = origin.getZ();
+
+        // the mesh only exists for 0 <= x <= sizeX - 1 and 0 <= y <= sizeY - 1
+        ray.t = 0;
+        ray.tEnd = maxDistance;
+        return clipSlab(ray.ox, ray.dirX, 0, static_cast<double>(heightField.getSizeX() - 1), ray.t, ray.tEnd) &&
+               clipSlab(ray.oy, ray.dirY, 0, static_cast<double>(heightField.getSizeY() - 1), ray.t, ray.tEnd);
+    }
+
+    // The part of the ray with t in [t0, t1] against the two triangles of one cell, fills in hit on a hit
+    template <typename Field>
+    bool hitCell(const Field& heightField, const ClippedRay& ray, int cellX, int cellY, double t0, double t1, HeightFieldHit& hit) {
+        double heights[4];
+        heightField.getCellHeights(cellX, cellY, heights);
+        double Ha = heights[0], Hb = heights[1], Hc = heights[2], Hd = heights[3];
+
+        // cheap reject: the ray stays above the highest corner for the whole cell
+        double zMin = ray.oz + std::min(t0 * ray.dirZ, t1 * ray.dirZ);
+        if (zMin > std::max(std::max(Ha, Hb), std::max(Hc, Hd))) return false;
+
+        bool abc = true;
+        double tHit = intersectCell(ray.ox - cellX, ray.oy - cellY, ray.oz, ray.dirX, ray.dirY, ray.dirZ, Ha, Hb, Hc, Hd, t0, t1, abc);
+        if (tHit < 0) return false;
+
+        CellPlane plane = trianglePlane(Ha, Hb, Hc, Hd, abc);
+        double hx = ray.ox + tHit * ray.dirX, hy = ray.oy + tHit * ray.dirY;
+        double nx = -plane.bx, ny = -plane.by, inverseLength = 1 / std::sqrt(nx * nx + ny * ny + 1);
+
+        hit.point = Vector3(static_cast<float>(hx), static_cast<float>(hy), static_cast<float>(plane.height(hx - cellX, hy - cellY)));
+        hit.normal = Vector3(static_cast<float>(nx * inverseLength), static_cast<float>(ny * inverseLength), static_cast<float>(inverseLength));
+        hit.cellX = cellX;
+        hit.cellY = cellY;
+        hit.distance = static_cast<float>(tHit);
+        return true;
+    }
+
+}
+
+// Casts the ray origin + t * direction (0 <= t <= maxDistance, direction does not need to be normalized) against the mesh
+// returns false if it misses, otherwise fills in hit. A ray that starts below the mesh hits at its origin.
+// Works on anything with getSizeX / getSizeY / getCellHeights (HeightField, QuantizedHeightField)
+template <typename Field>
+bool raycast(const Field& heightField, const Vector3& origin, const Vector3& direction, float maxDistance, HeightFieldHit& hit) {
+    using namespace HeightFieldRay;
+
+    ClippedRay ray;
+    if (!clipRay(heightField, origin, direction, maxDistance, ray)) return false;
+
+    // DDA setup: the cell the clipped ray starts in, and the t of the next x / y cell boundary
+    const double infinity = std::numeric_limits<double>::infinity();
+    const int lastCellX = static_cast<int>(heightField.getSizeX()) - 2;
+    const int lastCellY = static_cast<int>(heightField.getSizeY()) - 2;
+    int cellX = std::min(std::max(static_cast<int>(std::floor(ray.ox + ray.t * ray.dirX)), 0), lastCellX);
+    int cellY = std::min(std::max(static_cast<int>(std::floor(ray.oy + ray.t * ray.dirY)), 0), lastCellY);
+    int stepX = ray.dirX > 0 ? 1 : -1;
+    int stepY = ray.dirY > 0 ? 1 : -1;
+    double tDeltaX = ray.dirX != 0 ? 1 / std::abs(ray.dirX) : infinity;
+    double tDeltaY = ray.dirY != 0 ? 1 / std::abs(ray.dirY) : infinity;
+    double tNextX = ray.dirX != 0 ? ((ray.dirX > 0 ? cellX + 1 : cellX) - ray.ox) / ray.dirX : infinity;
+    double tNextY = ray.dirY != 0 ? ((ray.dirY > 0 ? cellY + 1 : cellY) - ray.oy) / ray.dirY : infinity;
+
+    double t = ray.t;
+    while (t <= ray.tEnd) {
+        double tExit = std::min(std::min(tNextX, tNextY), ray.tEnd);
+        if (hitCell(heightField, ray, cellX, cellY, t, tExit, hit)) return true;
+
+        // step into the next cell, through whichever boundary comes first
+        if (tExit >= ray.tEnd) break;
+        if (tNextX < tNextY) {
+            cellX += stepX;
+            tNextX += tDeltaX;
+            if (cellX < 0 || cellX > lastCellX) break;
+        }
+        else {
+            cellY += stepY;
+            tNextY += tDeltaY;
+            if (cellY < 0 || cellY > lastCellY) break;
+        }
+        t = tExit;
+    }
+    return false;
+}
@@ -0,0 +1,261 @@
+// Height field streamed from disk in tiles, for maps that do not fit in memory
+//
+// File format (native endianness):
+//   header: magic "QHF1", version (uint32), sizeX, sizeY, tileSize (uint64)
+//   tiles:  tilesX * tilesY tiles, tile (tx, ty) at index tx * tilesY + ty, each (tileSize + 1)^2 float samples x-major
+// Tile (tx, ty) covers the cells [tx * tileSize, (tx + 1) * tileSize) x [ty * tileSize, (ty + 1) * tileSize) and stores
+// one extra row and column of samples (shared with the next tile), so all four corners of any cell are in one tile and a
+// query never needs two tiles. Samples past the map edge are padded with the edge value.
+//
+// Only up to memoryBudget bytes of tiles are resident. A query for a tile that is not resident loads it (reading the
+// file with plain streaming reads) and evicts the least recently used tile if the budget is full. prefetch() loads the
+// tiles around a position ahead of time, so a moving camera / player finds its tiles already resident.
+
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <list>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+class PagedHeightField {
+public:
+    struct Stats {
+        std::size_t hits = 0;        // queries whose tile was already resident
+        std::size_t misses = 0;      // queries that had to wait for a tile to load
+        std::size_t tileLoads = 0;   // tiles read from disk (by queries and by prefetch)
+        std::size_t evictions = 0;
+
+        double hitRate() const { return hits + misses ? static_cast<double>(hits) / (hits + misses) : 0; }
+    };
+
+private:
+    struct Tile {
+        std::size_t id;                    // noTile while the slot holds no tile (a read into it failed)
+        std::vector<float> samples;
+        std::list<std::size_t>::iterator lruPosition;
+    };
+
+    static constexpr std::uint32_t magic = 0x31464851;   // "QHF1"
+    static constexpr std::uint32_t version = 1;
+    static constexpr std::size_t headerSize = 2 * sizeof(std::uint32_t) + 3 * sizeof(std::uint64_t);
+    static constexpr int notResident = -1;
+    static constexpr std::size_t noTile = static_cast<std::size_t>(-1);
+
+    std::ifstream file;
+    std::size_t sizeX = 0;
+    std::size_t sizeY = 0;
+    std::size_t tileSize = 0;
+    std::size_t tilesX = 0;
+    std::size_t tilesY = 0;
+    std::size_t maxResidentTiles = 0;
+
+    std::vector<Tile> tiles;               // resident tiles, at most maxResidentTiles
+    std::vector<int> tileSlots;            // tile id -> index into tiles, or notResident
+    std::list<std::size_t> lru;            // indices into tiles, most recently used first (free slots last)
+    std::size_t residentTiles = 0;         // slots in tiles that hold a tile
+    Stats stats;
+
+    std::size_t tileSamples() const { return (tileSize + 1) * (tileSize + 1); }
+
+    // reads tile id into a new slot (or the least recently used one) and returns the slot
+    // if the read fails the slot is left free at the back of lru, so it is the next one used, and the file stays usable
+    std::size_t load(std::size_t id) {
+        if (tiles.size() < maxResidentTiles) {
+            tiles.push_back(Tile{ noTile, std::vector<float>(tileSamples()), lru.end() });
+            lru.push_back(tiles.size() - 1);
+            tiles.back().lruPosition = std::prev(lru.end());
+        }
+        std::size_t slot = lru.back();
+        Tile& tile = tiles[slot];
+
+        // the read overwrites the samples, so the tile in the slot goes whether or not it succeeds
+        if (tile.id != noTile) {
+            tileSlots[tile.id] = notResident;
+            tile.id = noTile;
+            --residentTiles;
+            ++stats.evictions;
+        }
+
+        file.seekg(static_cast<std::streamoff>(headerSize + id * tileSamples() * sizeof(float)));
+        file.read(reinterpret_cast<char*>(tile.samples.data()), static_cast<std::streamsize>(tileSamples() * sizeof(float)));
+        if (!file) {
+            file.clear();
+            throw std::runtime_error("Could not read tile from the height field file.");
+        }
+
+        tile.id = id;
+        tileSlots[id] = static_cast<int>(slot);
+        ++residentTiles;
+        touch(slot);
+        ++stats.tileLoads;
+        return slot;
+    }
+
+    // marks a resident tile as most recently used
+    void touch(std::size_t slot) {
+        lru.splice(lru.begin(), lru, tiles[slot].lruPosition);
+    }
+
+    const Tile& acquire(std::size_t id) {
+        int slot = tileSlots[id];
+        if (slot != notResident) {
+            ++stats.hits;
+            touch(slot);
+            return tiles[slot];
+        }
+        ++stats.misses;
+        return tiles[load(id)];
+    }
+
+    template <typename Value>
+    static void writeValue(std::ofstream& out, Value value) {
+        out.write(reinterpret_cast<const char*>(&value), sizeof(Value));
+    }
+
+    template <typename Value>
+    static Value readValue(std::ifstream& in) {
+        Value value = Value();
+        in.read(reinterpret_cast<char*>(&value), sizeof(Value));
+        return value;
+    }
+
+public:
+    // Writes a sizeX by sizeY map to path, one tile at a time, so the whole map never has to be in memory
+    // sample(x, y) returns the height at grid point (x, y)
+    template <typename Sampler>
+    static void writeFile(const std::string& path, std::size_t sizeX, std::size_t sizeY, std::size_t tileSize, Sampler sample) {
+        if (sizeX < 2 || sizeY < 2 || tileSize == 0)
+            throw std::invalid_argument("Height field must be at least 2x2 with a non zero tile size.");
+
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        if (!out) throw std::runtime_error("Could not create height field file.");
+
+        writeValue(out, magic);
+        writeValue(out, version);
+        writeValue(out, static_cast<std::uint64_t>(sizeX));
+        writeValue(out, static_cast<std::uint64_t>(sizeY));
+        writeValue(out, static_cast<std::uint64_t>(tileSize));
+
+        std::size_t tilesX = (sizeX - 2) / tileSize + 1, tilesY = (sizeY - 2) / tileSize + 1;
+        std::vector<float> samples((tileSize + 1) * (tileSize + 1));
+        for (std::size_t tx = 0; tx < tilesX; ++tx) {
+            for (std::size_t ty = 0; ty < tilesY; ++ty) {
+                for (std::size_t x = 0; x <= tileSize; ++x)
+                    for (std::size_t y = 0; y <= tileSize; ++y)
+                        samples[x * (tileSize + 1) + y] = static_cast<float>(sample(std::min(tx * tileSize + x, sizeX - 1), std::min(ty * tileSize + y, sizeY - 1)));
+                out.write(reinterpret_cast<const char*>(samples.data()), static_cast<std::streamsize>(samples.size() * sizeof(float)));
+            }
+        }
+        if (!out) throw std::runtime_error("Could not write height field file.");
+    }
+
+    // Opens a file written by writeFile, keeping at most memoryBudget bytes of tiles resident (at least one tile)
+    PagedHeightField(const std::string& path, std::size_t memoryBudget) : file(path, std::ios::binary) {
+        if (!file) throw std::runtime_error("Could not open height field file.");
+        if (readValue<std::uint32_t>(file) != magic || readValue<std::uint32_t>(file) != version)
+            throw std::runtime_error("Not a height field file.");
+
+        sizeX = static_cast<std::size_t>(readValue<std::uint64_t>(file));
+        sizeY = static_cast<std::size_t>(readValue<std::uint64_t>(file));
+        tileSize = static_cast<std::size_t>(readValue<std::uint64_t>(file));
+        if (!file || sizeX < 2 || sizeY < 2 || tileSize == 0) throw std::runtime_error("Not a height field file.");
+
+        tilesX = (sizeX - 2) / tileSize + 1;
+        tilesY = (sizeY - 2) / tileSize + 1;
+        maxResidentTiles = std::max<std::size_t>(1, std::min(memoryBudget / (tileSamples() * sizeof(float)), tilesX * tilesY));
+        tiles.reserve(maxResidentTiles);
+        tileSlots.assign(tilesX * tilesY, notResident);
+    }
+
+    std::size_t getSizeX() const { return sizeX; }
+    std::size_t getSizeY() const { return sizeY; }
+    std::size_t getTileSize() const { return tileSize; }
+    std::size_t getResidentTileCount() const { return residentTiles; }
+    std::size_t getMaxResidentTiles() const { return maxResidentTiles; }
+
+    // bytes of tile data currently allocated (every slot, including one left free by a failed read)
+    std::size_t memoryUsage() const { return tiles.size() * tileSamples() * sizeof(float); }
+
+    const Stats& getStats() const { return stats; }
+    void resetStats() { stats = Stats(); }
+
+    // Exact height at (x, y), same triangulation, weights and bounds check as getExactHeight on a full height map
+    // loads the tile containing (x, y) if it is not resident
+    double getExactHeight(double x, double y) {
+        int Ax = static_cast<int>(x);
+        int Ay = static_cast<int>(y);
+
+        // Ensure we don't go out of bounds
+        if (Ax < 0 || Ay < 0 || static_cast<std::size_t>(Ax) + 1 >= sizeX || static_cast<std::size_t>(Ay) + 1 >= sizeY) {
+            throw std::out_of_range("Point is outside the height map bounds.");
+        }
+
+        std::size_t tileX = Ax / tileSize, tileY = Ay / tileSize;
+        const Tile& tile = acquire(tileX * tilesY + tileY);
+
+        // Define the four corners of the grid square, all inside this tile thanks to the shared edge
+        const float* A = tile.samples.data() + (Ax - tileX * tileSize) * (tileSize + 1) + (Ay - tileY * tileSize);
+        double Ha = A[0];                  // A (Bottom-left)
+        double Hb = A[tileSize + 1];       // B (Bottom-right)
+        double Hc = A[tileSize + 2];       // C (Top-right)
+        double Hd = A[1];                  // D (Top-left)
+
+        // Local coordinates inside the grid cell
+        double dx = x - Ax;
+        double dy = y - Ay;
+
+        // Determine which triangle (ABC or ACD)
+        if (dx >= dy) {
+            return (1 - dx) * Ha + (dx - dy) * Hb + dy * Hc;   // Triangle ABC
+        }
+        else {
+            return (1 - dy) * Ha + dx * Hc + (dy - dx) * Hd;   // Triangle ACD
+        }
+    }
+
+    // Makes the tiles within radius of (x, y) resident, nearest first, loading at most maxLoads of them
+    // (so the disk work can be spread over several frames). Tiles already resident are marked as recently used so they
+    // are not evicted in favour of tiles further away. Returns the number of tiles loaded.
+    std::size_t prefetch(double x, double y, double radius, std::size_t maxLoads = static_cast<std::size_t>(-1)) {
+        double cellX = std::min(std::max(x, 0.0), static_cast<double>(sizeX - 2));
+        double cellY = std::min(std::max(y, 0.0), static_cast<double>(sizeY - 2));
+        std::size_t tx0 = static_cast<std::size_t>(std::max(0.0, cellX - radius)) / tileSize;
+        std::size_t ty0 = static_cast<std::size_t>(std::max(0.0, cellY - radius)) / tileSize;
+        std::size_t tx1 = std::min(static_cast<std::size_t>(cellX + radius) / tileSize, tilesX - 1);
+        std::size_t ty1 = std::min(static_cast<std::size_t>(cellY + radius) / tileSize, tilesY - 1);
+
+        // tiles whose square comes within radius of the position, as (distance squared, id)
+        std::vector<std::pair<double, std::size_t>> wanted;
+        for (std::size_t tx = tx0; tx <= tx1; ++tx) {
+            for (std::size_t ty = ty0; ty <= ty1; ++ty) {
+                double nearestX = std::min(std::max(x, static_cast<double>(tx * tileSize)), static_cast<double>((tx + 1) * tileSize));
+                double nearestY = std::min(std::max(y, static_cast<double>(ty * tileSize)), static_cast<double>((ty + 1) * tileSize));
+                double distance = (nearestX - x) * (nearestX - x) + (nearestY - y) * (nearestY - y);
+                if (distance <= radius * radius) wanted.push_back(std::make_pair(distance, tx * tilesY + ty));
+            }
+        }
+        std::sort(wanted.begin(), wanted.end());
+        if (wanted.size() > maxResidentTiles) wanted.resize(maxResidentTiles);
+
+        // touch from far to near so the nearest tiles end up the most recently used
+        for (std::size_t i = wanted.size(); i-- > 0;)
+            if (tileSlots[wanted[i].second] != notResident) touch(tileSlots[wanted[i].second]);
+
+        std::size_t loads = 0;
+        for (std::size_t i = 0; i < wanted.size() && loads < maxLoads; ++i) {
+            if (tileSlots[wanted[i].second] == notResident) {
+                load(wanted[i].second);
+                ++loads;
+            }
+        }
+        return loads;
+    }
+};
@@ -0,0 +1,289 @@
+// Height field stored as 16 bit samples with a per-tile scale and offset (2 bytes per sample instead of 8 for double)
+//
+// Samples use TiledLayout<8>, so every 8x8 block of samples (128 bytes, two cache lines) is one tile with its own
+//   height = offset + scale * q,   offset = lowest height in the tile,   scale = (highest - lowest) / 65535
+// Quantization tolerance: a freshly quantized sample is within scale / 2 = (highest - lowest) / 131070 of the original
+// (plus float rounding of the decode), and since a height is a weighted average of three samples the same bound holds for
+// getExactHeight. Terrain that varies by less than 65 m inside 8x8 samples therefore keeps sub-millimetre precision.
+// A set() outside a tile's range re-quantizes the tile from its decoded samples, which adds the new half step to the
+// error already in them; every tile keeps that accumulated bound and getQuantizationTolerance reports the largest.
+//
+// getExactHeight and getCellHeights (which raycast reads through) decode the four corners of a cell with one SSE
+// multiply-add, and getExactHeights decodes 8 points at a time with AVX2 gathers.
+
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <algorithm>
+#include <array>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+#include "../MathLibrary/MathConfig.h"
+#include "HeightField.h"
+
+class QuantizedHeightField {
+public:
+    static constexpr std::size_t tileSize = 8;
+    typedef TiledLayout<tileSize> Layout;
+
+private:
+    static constexpr int tileShift = 6;   // log2(tileSize * tileSize), index >> tileShift is the tile of a sample
+
+    std::size_t sizeX;
+    std::size_t sizeY;
+    Layout layout;
+    std::vector<std::uint16_t, AlignedAllocator<std::uint16_t>> samples;   // one extra sample, see exactHeights8
+    std::vector<float> tileRanges;    // offset, scale of every tile, next to each other so a decode touches one cache line
+    std::vector<float> tileErrors;    // largest difference between a decoded sample of the tile and the height it was set to
+
+    float decode(std::size_t index) const {
+        const float* range = &tileRanges[2 * (index >> tileShift)];
+        return range[0] + range[1] * samples[index];
+    }
+
+    std::uint16_t encode(std::size_t tile, double height) const {
+        float offset = tileRanges[2 * tile], scale = tileRanges[2 * tile + 1];
+        if (scale == 0) return 0;
+        double q = std::round((height - offset) / scale);
+        return static_cast<std::uint16_t>(std::min(std::max(q, 0.0), 65535.0));
+    }
+
+    // picks offset / scale for every tile from its lowest and highest sample and encodes all samples
+    template <typename Sampler>
+    void quantize(Sampler height) {
+        for (std::size_t tileX = 0; tileX * tileSize < sizeX; ++tileX)
+            for (std::size_t tileY = 0; tileY * tileSize < sizeY; ++tileY)
+                quantizeTile(tileX, tileY, height);
+    }
+
+    // inheritedError is how far the heights passed in may already be from the ones they were set to
+    template <typename Sampler>
+    void quantizeTile(std::size_t tileX, std::size_t tileY, Sampler height, float inheritedError = 0.0f) {
+        std::size_t x0 = tileX * tileSize, y0 = tileY * tileSize;
+        std::size_t x1 = std::min(x0 + tileSize, sizeX), y1 = std::min(y0 + tileSize, sizeY);
+
+        double lowest = std::numeric_limits<double>::max(), highest = std::numeric_limits<double>::lowest();
+        for (std::size_t x = x0; x < x1; ++x) {
+            for (std::size_t y = y0; y < y1; ++y) {
+                lowest = std::min(lowest, static_cast<double>(height(x, y)));
+                highest = std::max(highest, static_cast<double>(height(x, y)));
+            }
+        }
+
+        std::size_t tile = layout.index(x0, y0) >> tileShift;
+        tileRanges[2 * tile] = static_cast<float>(lowest);
+        tileRanges[2 * tile + 1] = static_cast<float>((highest - lowest) / 65535.0);
+        tileErrors[tile] = inheritedError + tileRanges[2 * tile + 1] * 0.5f;
+        for (std::size_t x = x0; x < x1; ++x)
+            for (std::size_t y = y0; y < y1; ++y)
+                samples[layout.index(x, y)] = encode(tile, height(x, y));
+    }
+
+    void allocate() {
+        samples.assign(layout.storageSize() + 1, 0);
+        tileRanges.assign(2 * (layout.storageSize() / (tileSize * tileSize)), 0.0f);
+        tileErrors.assign(layout.storageSize() / (tileSize * tileSize), 0.0f);
+    }
+
+public:
+    // converts the original vector<vector<double>> format, heightMap[x][y]
+    explicit QuantizedHeightField(const std::vector<std::vector<double>>& heightMap)
+        : sizeX(heightMap.size()), sizeY(heightMap.empty() ? 0 : heightMap[0].size()), layout(sizeX, sizeY) {
+        for (const std::vector<double>& row : heightMap)
+            if (row.size() != sizeY)
+                throw std::invalid_argument("Height map rows must all have the same length.");
+        allocate();
+        quantize([&](std::size_t x, std::size_t y) { return heightMap[x][y]; });
+    }
+
+    template <typename T, typename SourceLayout>
+    explicit QuantizedHeightField(const HeightField<T, SourceLayout>& heightField)
+        : sizeX(heightField.getSizeX()), sizeY(heightField.getSizeY()), layout(sizeX, sizeY) {
+        allocate();
+        quantize([&](std::size_t x, std::size_t y) { return heightField.sample(x, y); });
+    }
+
+    std::size_t getSizeX() const { return sizeX; }
+    std::size_t getSizeY() const { return sizeY; }
+
+    // bytes used by the samples and the per-tile scale / offset / error bound
+    std::size_t memoryUsage() const {
+        return samples.size() * sizeof(std::uint16_t) + (tileRanges.size() + tileErrors.size()) * sizeof(float);
+    }
+
+    // largest difference between a decoded sample and the height it was built from or last set to (ignoring float
+    // rounding), including the error that widening edits have accumulated
+    float getQuantizationTolerance() const {
+        float largest = 0;
+        for (float error : tileErrors) largest = std::max(largest, error);
+        return largest;
+    }
+
+    // raw access for the batch queries
+    const Layout& getLayout() const { return layout; }
+    const std::uint16_t* data() const { return samples.data(); }
+    const float* getTileRanges() const { return tileRanges.data(); }
+
+    // read / write a single sample (with bounds checking)
+    float get(std::size_t x, std::size_t y) const {
+        if (x >= sizeX || y >= sizeY)
+            throw std::out_of_range("Sample is outside the height map bounds.");
+        return decode(layout.index(x, y));
+    }
+
+    // a height outside the tile's current range re-quantizes the whole tile with the widened range, from the decoded
+    // values, so the other samples of that tile pick up another half step of error each time that happens (added to
+    // the tile's error bound)
+    void set(std::size_t x, std::size_t y, float height) {
+        if (x >= sizeX || y >= sizeY)
+            throw std::out_of_range("Sample is outside the height map bounds.");
+
+        std::size_t index = layout.index(x, y), tile = index >> tileShift;
+        if (height >= tileRanges[2 * tile] && height <= tileRanges[2 * tile] + tileRanges[2 * tile + 1] * 65535.0f) {
+            samples[index] = encode(tile, height);
+            return;
+        }
+
+        std::size_t tileX = x / tileSize, tileY = y / tileSize;
+        std::array<float, tileSize * tileSize> decoded;
+        for (std::size_t i = 0; i < decoded.size(); ++i)
+            decoded[i] = decode((tile << tileShift) + i);
+        decoded[index - (tile << tileShift)] = height;
+        quantizeTile(tileX, tileY, [&](std::size_t sx, std::size_t sy) { return decoded[layout.index(sx, sy) - (tile << tileShift)]; },
+                     tileErrors[tile]);
+    }
+
+    // heights of the corners A, B, C and D of the cell at (x, y) (unchecked)
+    void getCellHeights(std::size_t x, std::size_t y, float heights[4]) const {
+        std::size_t corners[4];
+        layout.cellCorners(x, y, corners);
+#ifdef MATH_USE_SIMD
+        // (offset, scale) of two tiles per register, unpacked into four offsets and four scales
+        const float* ranges = tileRanges.data();
+        __m128 rangesAB = _mm_loadh_pi(_mm_loadl_pi(_mm_setzero_ps(), reinterpret_cast<const __m64*>(ranges + 2 * (corners[0] >> tileShift))),
+                                       reinterpret_cast<const __m64*>(ranges + 2 * (corners[1] >> tileShift)));
+        __m128 rangesCD = _mm_loadh_pi(_mm_loadl_pi(_mm_setzero_ps(), reinterpret_cast<const __m64*>(ranges + 2 * (corners[2] >> tileShift))),
+                                       reinterpret_cast<const __m64*>(ranges + 2 * (corners[3] >> tileShift)));
+        __m128 offset = _mm_shuffle_ps(rangesAB, rangesCD, _MM_SHUFFLE(2, 0, 2, 0));
+        __m128 scale = _mm_shuffle_ps(rangesAB, rangesCD, _MM_SHUFFLE(3, 1, 3, 1));
+        __m128 q = _mm_setr_ps(samples[corners[0]], samples[corners[1]], samples[corners[2]], samples[corners[3]]);
+        _mm_storeu_ps(heights, _mm_add_ps(offset, _mm_mul_ps(scale, q)));
+#else
+        for (int i = 0; i < 4; ++i)
+            heights[i] = decode(corners[i]);
+#endif
+    }
+
+    void getCellHeights(std::size_t x, std::size_t y, double heights[4]) const {
+        float decoded[4];
+        getCellHeights(x, y, decoded);
+        for (int i = 0; i < 4; ++i)
+            heights[i] = decoded[i];
+    }
+
+    // Exact height at (x, y) of the decoded mesh, same triangulation and bounds check as getExactHeight
+    double getExactHeight(double x, double y) const {
+        int Ax = static_cast<int>(x);
+        int Ay = static_cast<int>(y);
+
+        // Ensure we don't go out of bounds
+        if (Ax < 0 || Ay < 0 || static_cast<std::size_t>(Ax) + 1 >= sizeX || static_cast<std::size_t>(Ay) + 1 >= sizeY) {
+            throw std::out_of_range("Point is outside the height map bounds.");
+        }
+
+        float heights[4];
+        getCellHeights(Ax, Ay, heights);
+        double Ha = heights[0], Hb = heights[1], Hc = heights[2], Hd = heights[3];
+
+        // Local coordinates inside the grid cell
+        double dx = x - Ax;
+        double dy = y - Ay;
+
+        // Determine which triangle (ABC or ACD)
+        if (dx >= dy) {
+            return (1 - dx) * Ha + (dx - dy) * Hb + dy * Hc;   // Triangle ABC
+        }
+        else {
+            return (1 - dy) * Ha + dx * Hc + (dy - dx) * Hd;   // Triangle ACD
+        }
+    }
+
+#ifdef MATH_USE_AVX2
+    // 8 points of getExactHeights, the same branch-free formula as HeightFieldBatch::exactHeights8 with a decode after
+    // every gather. There is no 16 bit gather, so 32 bits are gathered at 2 byte steps and the upper half is masked off
+    // (the extra sample at the end of samples keeps the last read inside the buffer).
+    void exactHeights8(const float* xs, const float* ys, float* heights) const {
+        const __m256i one = _mm256_set1_epi32(1);
+
+        __m256 x = _mm256_loadu_ps(xs);
+        __m256 y = _mm256_loadu_ps(ys);
+        __m256i Ax = _mm256_cvttps_epi32(x);
+        __m256i Ay = _mm256_cvttps_epi32(y);
+
+        // Ensure we don't go out of bounds
+        __m256i outside = _mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpgt_epi32(_mm256_setzero_si256(), Ax), _mm256_cmpgt_epi32(_mm256_setzero_si256(), Ay)),
+            _mm256_or_si256(_mm256_cmpgt_epi32(_mm256_add_epi32(Ax, one), _mm256_set1_epi32(static_cast<int>(sizeX) - 1)),
+                            _mm256_cmpgt_epi32(_mm256_add_epi32(Ay, one), _mm256_set1_epi32(static_cast<int>(sizeY) - 1))));
+        if (!_mm256_testz_si256(outside, outside)) {
+            throw std::out_of_range("Point is outside the height map bounds.");
+        }
+
+        __m256 dx = _mm256_sub_ps(x, _mm256_cvtepi32_ps(Ax));
+        __m256 dy = _mm256_sub_ps(y, _mm256_cvtepi32_ps(Ay));
+        __m256i upperMask = _mm256_castps_si256(_mm256_cmp_ps(dx, dy, _CMP_GE_OQ));   // Triangle ABC
+        __m256i Mx = _mm256_add_epi32(Ax, _mm256_and_si256(upperMask, one));
+        __m256i My = _mm256_add_epi32(Ay, _mm256_andnot_si256(upperMask, one));
+
+        __m256 Ha = decode8(layout.index8(Ax, Ay));
+        __m256 Hc = decode8(layout.index8(_mm256_add_epi32(Ax, one), _mm256_add_epi32(Ay, one)));
+        __m256 Hm = decode8(layout.index8(Mx, My));
+
+        __m256 big = _mm256_max_ps(dx, dy);
+        __m256 small = _mm256_min_ps(dx, dy);
+#ifdef __FMA__
+        __m256 height = _mm256_fmadd_ps(big, _mm256_sub_ps(Hm, Ha), Ha);
+        height = _mm256_fmadd_ps(small, _mm256_sub_ps(Hc, Hm), height);
+#else
+        __m256 height = _mm256_add_ps(Ha, _mm256_mul_ps(big, _mm256_sub_ps(Hm, Ha)));
+        height = _mm256_add_ps(height, _mm256_mul_ps(small, _mm256_sub_ps(Hc, Hm)));
+#endif
+        _mm256_storeu_ps(heights, height);
+    }
+
+private:
+    __m256 decode8(__m256i index) const {
+        __m256i q = _mm256_and_si256(_mm256_i32gather_epi32(reinterpret_cast<const int*>(samples.data()), index, 2), _mm256_set1_epi32(0xffff));
+        __m256i range = _mm256_slli_epi32(_mm256_srli_epi32(index, tileShift), 1);
+        __m256 offset = _mm256_i32gather_ps(tileRanges.data(), range, 4);
+        __m256 scale = _mm256_i32gather_ps(tileRanges.data() + 1, range, 4);
+#ifdef __FMA__
+        return _mm256_fmadd_ps(scale, _mm256_cvtepi32_ps(q), offset);
+#else
+        return _mm256_add_ps(offset, _mm256_mul_ps(scale, _mm256_cvtepi32_ps(q)));
+#endif
+    }
+#endif
+};
+
+// Height under each of count points, heights[i] = quantizedField.getExactHeight(xs[i], ys[i]) in float precision
+// throws std::out_of_range if any point is outside the map (heights before the failing group of 8 are already written)
+inline void getExactHeights(const QuantizedHeightField& heightField, const float* xs, const float* ys, float* heights, std::size_t count) {
+    std::size_t i = 0;
+#ifdef MATH_USE_AVX2
+    // gathers take 32 bit indices (at 2 byte steps here)
+    if (heightField.getLayout().storageSize() <= static_cast<std::size_t>(std::numeric_limits<int>::max()) / 2 &&
+        std::max(heightField.getSizeX(), heightField.getSizeY()) <= 65536) {
+        for (; i + 8 <= count; i += 8) {
+            heightField.exactHeights8(xs + i, ys + i, heights + i);
+        }
+    }
+#endif
+    for (; i < count; ++i) {
+        heights[i] = static_cast<float>(heightField.getExactHeight(xs[i], ys[i]));
+    }
+}
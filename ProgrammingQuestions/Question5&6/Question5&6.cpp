@@ -1,4 +1,4 @@
-﻿// Given that you have a 2 dimensional array of height values (say 10x10) that represent a height field. 
+// Given that you have a 2 dimensional array of height values (say 10x10) that represent a height field. 
 // Assume that the distance between each height point in X and Y is 1 
 // and that from the grid we form a triangulated mesh such that 
 // for each set of 4 grid points A=(x,y), B=(x+1,y) C=(x+1,y+1), and D=(x,y+1) 
@@ -69,6 +69,23 @@ A(x,y)           B(x+1,y)
 
 #include <iostream>
 #include <vector>
+#include <cmath>
+#include <chrono>
+#include <random>
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+
+#include "../MathLibrary/Vector2.h"
+#include "../MathLibrary/Vector3.h"
+#include "HeightField.h"
+#include "HeightFieldBatch.h"
+#include "HeightFieldRay.h"
+#include "HeightFieldPyramid.h"
+#include "PagedHeightField.h"
+#include "HeightFieldPlanes.h"
+#include "QuantizedHeightField.h"
 
 using namespace std;
 
@@ -114,6 +131,566 @@ double getExactHeight(const vector<vector<double>>& heightMap, double x, double
     }
 }
 
+// Same query taking a position from the shared math library, so gameplay code can pass its positions straight in
+double getExactHeight(const vector<vector<double>>& heightMap, const Vector2& point) {
+    return getExactHeight(heightMap, point.getX(), point.getY());
+}
+
+// The point on the mesh directly above (or below) the given grid position, as (x, y, height)
+Vector3 getSurfacePoint(const vector<vector<double>>& heightMap, const Vector2& point) {
+    return Vector3(point.getX(), point.getY(), static_cast<float>(getExactHeight(heightMap, point)));
+}
+
+// ---------------------------------------------------------------------------------------------
+// Benchmarks
+// ---------------------------------------------------------------------------------------------
+
+// Rolling hills test terrain, heightMap[x][y]
+vector<vector<double>> makeTestTerrain(size_t size) {
+    vector<vector<double>> heightMap(size, vector<double>(size));
+    for (size_t x = 0; x < size; ++x)
+        for (size_t y = 0; y < size; ++y)
+            heightMap[x][y] = 50.0 * std::sin(x * 0.01) * std::cos(y * 0.013) + 5.0 * std::sin((x + y) * 0.1);
+    return heightMap;
+}
+
+// Runs query(x, y) for every point and reports ns per query, the summed heights double as a checksum
+template <typename Query>
+void benchmarkHeightQueries(const char* label, const vector<double>& xs, const vector<double>& ys, Query query, double linesPerQuery) {
+    double checksum = 0;
+    auto start = std::chrono::high_resolution_clock::now();
+    for (size_t i = 0; i < xs.size(); ++i)
+        checksum += query(xs[i], ys[i]);
+    auto end = std::chrono::high_resolution_clock::now();
+
+    double ns = std::chrono::duration<double, std::nano>(end - start).count() / xs.size();
+    cout << "  " << label << ": " << ns << " ns/query, " << linesPerQuery << " cache lines/query (checksum " << checksum << ")" << endl;
+}
+
+// Number of distinct 64 byte cache lines four corner reads touch
+size_t countCacheLines(const void* a, const void* b, const void* c, const void* d) {
+    uintptr_t lines[4] = { reinterpret_cast<uintptr_t>(a) / 64, reinterpret_cast<uintptr_t>(b) / 64,
+                           reinterpret_cast<uintptr_t>(c) / 64, reinterpret_cast<uintptr_t>(d) / 64 };
+    sort(lines, lines + 4);
+    return unique(lines, lines + 4) - lines;
+}
+
+// Average number of cache lines the corner reads of a query touch, over the given query points
+double averageCacheLines(const vector<vector<double>>& heightMap, const vector<double>& xs, const vector<double>& ys) {
+    size_t total = 0;
+    for (size_t i = 0; i < xs.size(); ++i) {
+        size_t x = static_cast<size_t>(xs[i]), y = static_cast<size_t>(ys[i]);
+        total += countCacheLines(&heightMap[x][y], &heightMap[x + 1][y], &heightMap[x + 1][y + 1], &heightMap[x][y + 1]);
+    }
+    return static_cast<double>(total) / xs.size();
+}
+
+template <typename T, typename Layout>
+double averageCacheLines(const HeightField<T, Layout>& field, const vector<double>& xs, const vector<double>& ys) {
+    size_t total = 0;
+    for (size_t i = 0; i < xs.size(); ++i) {
+        size_t corners[4];
+        field.getLayout().cellCorners(static_cast<size_t>(xs[i]), static_cast<size_t>(ys[i]), corners);
+        const T* data = field.data();
+        total += countCacheLines(data + corners[0], data + corners[1], data + corners[2], data + corners[3]);
+    }
+    return static_cast<double>(total) / xs.size();
+}
+
+void runHeightFieldBenchmarks() {
+    const size_t size = 4096;
+    const size_t queryCount = 4000000;
+
+    vector<vector<double>> heightMap = makeTestTerrain(size);
+
+    // random points all over the map, the worst case for the cache
+    std::mt19937 random(42);
+    std::uniform_real_distribution<double> coordinate(0.0, size - 1.001);
+    vector<double> xs(queryCount), ys(queryCount);
+    for (size_t i = 0; i < queryCount; ++i) {
+        xs[i] = coordinate(random);
+        ys[i] = coordinate(random);
+    }
+
+    cout << endl << "Height query benchmark (" << size << "x" << size << " map, " << queryCount << " random queries)" << endl;
+    benchmarkHeightQueries("vector<vector<double>>      ", xs, ys, [&](double x, double y) { return getExactHeight(heightMap, x, y); }, averageCacheLines(heightMap, xs, ys));
+    {
+        HeightField<double, RowMajorLayout> field(heightMap);
+        benchmarkHeightQueries("HeightField<double, RowMajor>", xs, ys, [&](double x, double y) { return getExactHeight(field, x, y); }, averageCacheLines(field, xs, ys));
+    }
+    {
+        HeightField<double, TiledLayout<4>> field(heightMap);
+        benchmarkHeightQueries("HeightField<double, Tiled4>  ", xs, ys, [&](double x, double y) { return getExactHeight(field, x, y); }, averageCacheLines(field, xs, ys));
+    }
+    {
+        HeightField<double, MortonLayout> field(heightMap);
+        benchmarkHeightQueries("HeightField<double, Morton>  ", xs, ys, [&](double x, double y) { return getExactHeight(field, x, y); }, averageCacheLines(field, xs, ys));
+    }
+    {
+        HeightField<float, TiledLayout<4>> field(heightMap);
+        benchmarkHeightQueries("HeightField<float, Tiled4>   ", xs, ys, [&](double x, double y) { return getExactHeight(field, x, y); }, averageCacheLines(field, xs, ys));
+    }
+}
+
+// Agents per frame: one getExactHeight call per agent against one getExactHeights call for the whole frame
+template <typename Layout>
+void benchmarkBatchQueries(const char* label, const HeightField<float, Layout>& field, const vector<float>& xs, const vector<float>& ys, int frames) {
+    const size_t count = xs.size();
+    vector<float> single(count), batch(count);
+
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int frame = 0; frame < frames; ++frame)
+        for (size_t i = 0; i < count; ++i)
+            single[i] = static_cast<float>(getExactHeight(field, xs[i], ys[i]));
+    auto middle = std::chrono::high_resolution_clock::now();
+    for (int frame = 0; frame < frames; ++frame)
+        getExactHeights(field, xs.data(), ys.data(), batch.data(), count);
+    auto end = std::chrono::high_resolution_clock::now();
+
+    double maxError = 0;
+    for (size_t i = 0; i < count; ++i)
+        maxError = std::max(maxError, std::abs(static_cast<double>(batch[i]) - single[i]));
+
+    double singleMs = std::chrono::duration<double, std::milli>(middle - start).count() / frames;
+    double batchMs = std::chrono::duration<double, std::milli>(end - middle).count() / frames;
+    cout << "  " << label << ": per query " << singleMs << " ms/frame, batch " << batchMs << " ms/frame ("
+         << singleMs / batchMs << "x, max difference " << maxError << ")" << endl;
+}
+
+void runBatchHeightBenchmarks() {
+    const size_t size = 4096;
+    const size_t agentCount = 100000;
+    const int frames = 20;
+
+    vector<vector<double>> heightMap = makeTestTerrain(size);
+
+    // agents spread over the whole map, and agents grouped in a 256x256 area (a crowd / battle around the camera);
+    // only the grouped agents reach 4x and more, spread ones are bound by cache misses (see HeightFieldBatch.h)
+    std::mt19937 random(42);
+    std::uniform_real_distribution<float> coordinate(0.0f, size - 1.001f);
+    std::uniform_real_distribution<float> nearby(1000.0f, 1256.0f);
+    vector<float> spreadXs(agentCount), spreadYs(agentCount), groupXs(agentCount), groupYs(agentCount);
+    for (size_t i = 0; i < agentCount; ++i) {
+        spreadXs[i] = coordinate(random);
+        spreadYs[i] = coordinate(random);
+        groupXs[i] = nearby(random);
+        groupYs[i] = nearby(random);
+    }
+
+    cout << endl << "Batch height queries (" << agentCount << " agents per frame, " << size << "x" << size << " float map)" << endl;
+    {
+        HeightField<float, RowMajorLayout> field(heightMap);
+        benchmarkBatchQueries("RowMajor, spread ", field, spreadXs, spreadYs, frames);
+        benchmarkBatchQueries("RowMajor, grouped", field, groupXs, groupYs, frames);
+    }
+    {
+        HeightField<float, TiledLayout<4>> field(heightMap);
+        benchmarkBatchQueries("Tiled4, spread   ", field, spreadXs, spreadYs, frames);
+        benchmarkBatchQueries("Tiled4, grouped  ", field, groupXs, groupYs, frames);
+    }
+    {
+        HeightField<float, MortonLayout> field(heightMap);
+        benchmarkBatchQueries("Morton, spread   ", field, spreadXs, spreadYs, frames);
+        benchmarkBatchQueries("Morton, grouped  ", field, groupXs, groupYs, frames);
+    }
+}
+
+// Casts every ray and reports rays per second, plus how far the hits are from getExactHeight at the hit point
+template <typename T, typename Layout>
+void benchmarkRaycasts(const char* label, const HeightField<T, Layout>& field, const vector<Vector3>& origins, const vector<Vector3>& directions, float maxDistance) {
+    vector<HeightFieldHit> hits(origins.size());
+    vector<char> hitFlags(origins.size());
+
+    auto start = std::chrono::high_resolution_clock::now();
+    for (size_t i = 0; i < origins.size(); ++i)
+        hitFlags[i] = raycast(field, origins[i], directions[i], maxDistance, hits[i]);
+    auto end = std::chrono::high_resolution_clock::now();
+
+    size_t hitCount = 0;
+    double totalDistance = 0, maxError = 0;
+    for (size_t i = 0; i < origins.size(); ++i) {
+        if (!hitFlags[i]) continue;
+        ++hitCount;
+        totalDistance += hits[i].distance;
+        // getExactHeight does not accept points on the last row / column of the grid, the ray can still hit there
+        if (hits[i].point.getX() >= field.getSizeX() - 1 || hits[i].point.getY() >= field.getSizeY() - 1) continue;
+        double surface = getExactHeight(field, hits[i].point.getX(), hits[i].point.getY());
+        maxError = std::max(maxError, std::abs(surface - hits[i].point.getZ()));
+    }
+
+    double seconds = std::chrono::duration<double>(end - start).count();
+    cout << "  " << label << ": " << origins.size() / seconds / 1e6 << " M rays/s, " << hitCount << " hits, average hit distance "
+         << (hitCount ? totalDistance / hitCount : 0) << ", max |hit height - getExactHeight| " << maxError << endl;
+}
+
+void runRaycastBenchmarks() {
+    const size_t size = 4096;
+    const size_t rayCount = 20000;
+
+    HeightField<float, TiledLayout<4>> field(makeTestTerrain(size));
+
+    std::mt19937 random(7);
+    std::uniform_real_distribution<float> coordinate(0.0f, size - 1.0f);
+    std::uniform_real_distribution<float> angle(0.0f, 6.2831853f);
+    vector<Vector3> origins(rayCount), shallow(rayCount), steep(rayCount), level(rayCount);
+    for (size_t i = 0; i < rayCount; ++i) {
+        float a = angle(random);
+        origins[i] = Vector3(coordinate(random), coordinate(random), 80.0f);
+        shallow[i] = Vector3(std::cos(a), std::sin(a), -0.05f);   // line of sight / long range shots, hundreds of cells
+        steep[i] = Vector3(std::cos(a), std::sin(a), -2.0f);      // falling projectiles, a few dozen cells
+        level[i] = Vector3(std::cos(a), std::sin(a), 0.0f);       // above everything, walks to the map edge and misses
+    }
+
+    cout << endl << "Ray casts (" << rayCount << " rays, " << size << "x" << size << " float map)" << endl;
+    benchmarkRaycasts("shallow", field, origins, shallow, 10000.0f);
+    benchmarkRaycasts("steep  ", field, origins, steep, 10000.0f);
+    benchmarkRaycasts("level  ", field, origins, level, 10000.0f);
+}
+
+// Same rays with and without the min / max pyramid, the hits have to be identical
+template <typename T, typename Layout>
+void benchmarkPyramidRaycasts(const char* label, const HeightField<T, Layout>& field, const HeightFieldPyramid<T, Layout>& pyramid,
+                              const vector<Vector3>& origins, const vector<Vector3>& directions, float maxDistance) {
+    vector<HeightFieldHit> plainHits(origins.size()), pyramidHits(origins.size());
+    vector<char> plainFlags(origins.size()), pyramidFlags(origins.size());
+
+    auto start = std::chrono::high_resolution_clock::now();
+    for (size_t i = 0; i < origins.size(); ++i)
+        plainFlags[i] = raycast(field, origins[i], directions[i], maxDistance, plainHits[i]);
+    auto middle = std::chrono::high_resolution_clock::now();
+    for (size_t i = 0; i < origins.size(); ++i)
+        pyramidFlags[i] = raycast(pyramid, origins[i], directions[i], maxDistance, pyramidHits[i]);
+    auto end = std::chrono::high_resolution_clock::now();
+
+    size_t mismatches = 0;
+    for (size_t i = 0; i < origins.size(); ++i)
+        if (plainFlags[i] != pyramidFlags[i] || (plainFlags[i] && plainHits[i].distance != pyramidHits[i].distance))
+            ++mismatches;
+
+    double plainRate = origins.size() / std::chrono::duration<double>(middle - start).count() / 1e6;
+    double pyramidRate = origins.size() / std::chrono::duration<double>(end - middle).count() / 1e6;
+    cout << "  " << label << ": DDA " << plainRate << " M rays/s, pyramid " << pyramidRate << " M rays/s ("
+         << pyramidRate / plainRate << "x, " << mismatches << " different hits)" << endl;
+}
+
+void runPyramidBenchmarks() {
+    const size_t size = 4096;
+    const size_t rayCount = 20000;
+    const size_t regionCount = 100000;
+
+    HeightField<float, TiledLayout<4>> field(makeTestTerrain(size));
+
+    auto buildStart = std::chrono::high_resolution_clock::now();
+    HeightFieldPyramid<float, TiledLayout<4>> pyramid(field);
+    auto buildEnd = std::chrono::high_resolution_clock::now();
+
+    cout << endl << "Min / max pyramid (" << size << "x" << size << " float map, " << pyramid.getLevelCount() << " levels, "
+         << pyramid.memoryUsage() / (1024 * 1024) << " MB next to " << field.memoryUsage() / (1024 * 1024) << " MB of samples, built in " << std::chrono::duration<double, std::milli>(buildEnd - buildStart).count() << " ms)" << endl;
+
+    // "max height in region", e.g. can a flyer / artillery shell clear this area, against scanning every sample
+    std::mt19937 random(11);
+    std::uniform_int_distribution<size_t> corner(0, size - 258);
+    std::uniform_int_distribution<size_t> extent(0, 255);
+    vector<size_t> x0s(regionCount), y0s(regionCount), x1s(regionCount), y1s(regionCount);
+    for (size_t i = 0; i < regionCount; ++i) {
+        x0s[i] = corner(random);
+        y0s[i] = corner(random);
+        x1s[i] = x0s[i] + extent(random);
+        y1s[i] = y0s[i] + extent(random);
+    }
+
+    const size_t scanCount = regionCount / 100;
+    size_t mismatches = 0;
+    auto scanStart = std::chrono::high_resolution_clock::now();
+    for (size_t i = 0; i < scanCount; ++i) {
+        float highest = field.sample(x0s[i], y0s[i]);
+        for (size_t x = x0s[i]; x <= x1s[i] + 1; ++x)
+            for (size_t y = y0s[i]; y <= y1s[i] + 1; ++y)
+                highest = std::max(highest, field.sample(x, y));
+        mismatches += highest != pyramid.getMaxHeight(x0s[i], y0s[i], x1s[i], y1s[i]);
+    }
+    auto scanEnd = std::chrono::high_resolution_clock::now();
+
+    double checksum = 0;
+    auto queryStart = std::chrono::high_resolution_clock::now();
+    for (size_t i = 0; i < regionCount; ++i)
+        checksum += pyramid.getMaxHeight(x0s[i], y0s[i], x1s[i], y1s[i]);
+    auto queryEnd = std::chrono::high_resolution_clock::now();
+
+    double scanUs = std::chrono::duration<double, std::micro>(scanEnd - scanStart).count() / scanCount;
+    double queryUs = std::chrono::duration<double, std::micro>(queryEnd - queryStart).count() / regionCount;
+    cout << "  max height in region (up to 256x256 cells): scan " << scanUs << " us, pyramid " << queryUs << " us ("
+         << scanUs / queryUs << "x, " << mismatches << " different results, checksum " << checksum << ")" << endl;
+
+    // the same long rays as the plain ray cast benchmark
+    std::uniform_real_distribution<float> coordinate(0.0f, size - 1.0f);
+    std::uniform_real_distribution<float> angle(0.0f, 6.2831853f);
+    vector<Vector3> origins(rayCount), shallow(rayCount), level(rayCount);
+    for (size_t i = 0; i < rayCount; ++i) {
+        float a = angle(random);
+        origins[i] = Vector3(coordinate(random), coordinate(random), 80.0f);
+        shallow[i] = Vector3(std::cos(a), std::sin(a), -0.05f);
+        level[i] = Vector3(std::cos(a), std::sin(a), 0.0f);
+    }
+    benchmarkPyramidRaycasts("shallow rays", field, pyramid, origins, shallow, 10000.0f);
+    benchmarkPyramidRaycasts("level rays  ", field, pyramid, origins, level, 10000.0f);
+
+    // dig 1000 small craters, updating the pyramid after each one, against rebuilding it once
+    auto editStart = std::chrono::high_resolution_clock::now();
+    for (int crater = 0; crater < 1000; ++crater) {
+        size_t cx = corner(random), cy = corner(random);
+        for (size_t x = cx; x < cx + 16; ++x)
+            for (size_t y = cy; y < cy + 16; ++y)
+                field.set(x, y, field.get(x, y) - 3.0f);
+        pyramid.update(cx, cy, cx + 15, cy + 15);
+    }
+    auto editEnd = std::chrono::high_resolution_clock::now();
+    HeightFieldPyramid<float, TiledLayout<4>> rebuilt(field);
+    auto rebuildEnd = std::chrono::high_resolution_clock::now();
+
+    bool same = true;
+    for (int l = 1; l < pyramid.getLevelCount() && same; ++l)
+        for (size_t x = 0; x < pyramid.getLevelSizeX(l) && same; ++x)
+            for (size_t y = 0; y < pyramid.getLevelSizeY(l); ++y)
+                if (pyramid.getRange(l, x, y).maxHeight != rebuilt.getRange(l, x, y).maxHeight ||
+                    pyramid.getRange(l, x, y).minHeight != rebuilt.getRange(l, x, y).minHeight) { same = false; break; }
+
+    cout << "  16x16 edit + update: " << std::chrono::duration<double, std::micro>(editEnd - editStart).count() / 1000 << " us, full rebuild "
+         << std::chrono::duration<double, std::micro>(rebuildEnd - editEnd).count() << " us (" << (same ? "matches" : "DIFFERS FROM") << " the rebuilt pyramid)" << endl;
+}
+
+// Camera flying over a streamed map with agents around it, reports tile cache hit rate and query latency
+void runFlyThrough(const char* label, const std::string& path, size_t memoryBudget, bool usePrefetch) {
+    const int frames = 1500;
+    const int queriesPerFrame = 2000;
+    const double agentRadius = 256;
+
+    PagedHeightField terrain(path, memoryBudget);
+    std::mt19937 random(5);
+    std::uniform_real_distribution<double> offset(-agentRadius, agentRadius);
+    vector<double> latencies;
+    latencies.reserve(static_cast<size_t>(frames) * queriesPerFrame);
+    double checksum = 0;
+
+    double center = terrain.getSizeX() / 2.0, range = terrain.getSizeX() / 2.0 - 400;
+    for (int frame = 0; frame < frames; ++frame) {
+        double cameraX = center + range * std::sin(frame * 0.0011), cameraY = center + range * std::sin(frame * 0.0017 + 1.0);
+        if (usePrefetch) terrain.prefetch(cameraX, cameraY, agentRadius + 160, 4);
+
+        for (int i = 0; i < queriesPerFrame; ++i) {
+            double x = cameraX + offset(random), y = cameraY + offset(random);
+            auto start = std::chrono::steady_clock::now();
+            checksum += terrain.getExactHeight(x, y);
+            auto end = std::chrono::steady_clock::now();
+            latencies.push_back(std::chrono::duration<double, std::nano>(end - start).count());
+        }
+    }
+
+    std::sort(latencies.begin(), latencies.end());
+    double average = 0;
+    for (double latency : latencies) average += latency;
+    average /= latencies.size();
+
+    const PagedHeightField::Stats& stats = terrain.getStats();
+    cout << "  " << label << ": hit rate " << stats.hitRate() * 100 << "%, " << stats.tileLoads << " tile loads, " << stats.evictions << " evictions, latency avg "
+         << average << " ns, p99 " << latencies[latencies.size() * 99 / 100] << " ns, max " << latencies.back() / 1000 << " us (checksum " << checksum << ")" << endl;
+}
+
+void runPagedTerrainBenchmarks() {
+    const size_t size = 8192;
+    const size_t tileSize = 128;
+    const size_t memoryBudget = 16 * 1024 * 1024;
+    const std::string path = (std::filesystem::temp_directory_path() / "QGamesTrial_terrain.qhf").string();
+
+    // the same rolling hills as makeTestTerrain, written tile by tile without ever holding the whole map
+    PagedHeightField::writeFile(path, size, size, tileSize,
+        [](size_t x, size_t y) { return 50.0 * std::sin(x * 0.01) * std::cos(y * 0.013) + 5.0 * std::sin((x + y) * 0.1); });
+
+    cout << endl << "Paged terrain fly-through (" << size << "x" << size << " map = " << size * size * sizeof(float) / (1024 * 1024) << " MB of floats, "
+         << memoryBudget / (1024 * 1024) << " MB tile budget, " << tileSize << "x" << tileSize << " tiles)" << endl;
+    runFlyThrough("on demand", path, memoryBudget, false);
+    runFlyThrough("prefetch ", path, memoryBudget, true);
+
+    std::remove(path.c_str());
+}
+
+// Normal of the triangle under (x, y) computed from the four corners every time, what callers had to do without the cache
+template <typename T, typename Layout>
+Vector3 computeNormal(const HeightField<T, Layout>& field, float x, float y) {
+    size_t Ax = static_cast<size_t>(x), Ay = static_cast<size_t>(y);
+    float Ha = field.sample(Ax, Ay), Hb = field.sample(Ax + 1, Ay), Hc = field.sample(Ax + 1, Ay + 1), Hd = field.sample(Ax, Ay + 1);
+    bool abc = x - Ax >= y - Ay;
+    float gx = abc ? Hb - Ha : Hc - Hd, gy = abc ? Hc - Hb : Hd - Ha;
+    return Vector3(-gx, -gy, 1.0f).normalized();
+}
+
+// Height only and height + normal, recomputed from the samples against read from the plane cache
+void benchmarkPlaneCache(const char* label, const HeightField<float, TiledLayout<4>>& field, const HeightFieldPlaneCache<float, TiledLayout<4>>& planes,
+                         const vector<float>& xs, const vector<float>& ys) {
+    double heightSum = 0, normalSum = 0, maxHeightError = 0, maxNormalError = 0;
+
+    auto t0 = std::chrono::high_resolution_clock::now();
+    for (size_t i = 0; i < xs.size(); ++i)
+        heightSum += getExactHeight(field, xs[i], ys[i]);
+    auto t1 = std::chrono::high_resolution_clock::now();
+    for (size_t i = 0; i < xs.size(); ++i)
+        heightSum -= planes.getExactHeight(xs[i], ys[i]);
+    auto t2 = std::chrono::high_resolution_clock::now();
+    for (size_t i = 0; i < xs.size(); ++i)
+        normalSum += getExactHeight(field, xs[i], ys[i]) + computeNormal(field, xs[i], ys[i]).getZ();
+    auto t3 = std::chrono::high_resolution_clock::now();
+    for (size_t i = 0; i < xs.size(); ++i) {
+        Vector3 normal;
+        normalSum -= planes.getHeightAndNormal(xs[i], ys[i], normal) + normal.getZ();
+    }
+    auto t4 = std::chrono::high_resolution_clock::now();
+
+    for (size_t i = 0; i < xs.size(); i += 16) {
+        maxHeightError = std::max(maxHeightError, std::abs(getExactHeight(field, xs[i], ys[i]) - planes.getExactHeight(xs[i], ys[i])));
+        Vector3 difference = computeNormal(field, xs[i], ys[i]) - planes.getNormal(xs[i], ys[i]);
+        maxNormalError = std::max(maxNormalError, static_cast<double>(difference.length()));
+    }
+
+    auto ns = [&](std::chrono::high_resolution_clock::time_point a, std::chrono::high_resolution_clock::time_point b) {
+        return std::chrono::duration<double, std::nano>(b - a).count() / xs.size();
+    };
+    cout << "  " << label << ": height " << ns(t0, t1) << " -> " << ns(t1, t2) << " ns, height + normal " << ns(t2, t3) << " -> " << ns(t3, t4)
+         << " ns (max difference height " << maxHeightError << ", normal " << maxNormalError << ", checksums " << heightSum << " " << normalSum << ")" << endl;
+}
+
+void runPlaneCacheBenchmarks() {
+    const size_t size = 2048;
+    const size_t queryCount = 2000000;
+
+    HeightField<float, TiledLayout<4>> field(makeTestTerrain(size));
+    HeightFieldPlaneCache<float, TiledLayout<4>> planes(field);
+
+    std::mt19937 random(21);
+    std::uniform_real_distribution<float> coordinate(0.0f, size - 1.001f);
+    std::uniform_real_distribution<float> nearby(1000.0f, 1128.0f);
+    vector<float> spreadXs(queryCount), spreadYs(queryCount), groupXs(queryCount), groupYs(queryCount);
+    for (size_t i = 0; i < queryCount; ++i) {
+        spreadXs[i] = coordinate(random);
+        spreadYs[i] = coordinate(random);
+        groupXs[i] = nearby(random);
+        groupYs[i] = nearby(random);
+    }
+
+    cout << endl << "Plane cache (" << size << "x" << size << " float map, " << planes.memoryUsage() / (1024 * 1024) << " MB of planes, samples -> cache)" << endl;
+    benchmarkPlaneCache("spread ", field, planes, spreadXs, spreadYs);
+    benchmarkPlaneCache("grouped", field, planes, groupXs, groupYs);
+
+    // raise a 32x32 plateau and rebuild only the cells around it
+    for (size_t x = 500; x < 532; ++x)
+        for (size_t y = 500; y < 532; ++y)
+            field.set(x, y, field.get(x, y) + 10.0f);
+    auto start = std::chrono::high_resolution_clock::now();
+    planes.update(500, 500, 531, 531);
+    auto end = std::chrono::high_resolution_clock::now();
+    cout << "  32x32 edit: update " << std::chrono::duration<double, std::micro>(end - start).count() << " us, height at (531.5, 520.2) "
+         << planes.getExactHeight(531.5f, 520.2f) << " (HeightField " << getExactHeight(field, 531.5, 520.2) << ")" << endl;
+}
+
+// 16 bit samples against double / float samples: memory, single and batch query time, ray casts, and how far off they are
+void runQuantizedBenchmarks() {
+    const size_t size = 4096;
+    const size_t queryCount = 1000000;
+    const size_t rayCount = 20000;
+
+    vector<vector<double>> heightMap = makeTestTerrain(size);
+    HeightField<double, RowMajorLayout> exact(heightMap);
+    HeightField<float, TiledLayout<4>> floats(heightMap);
+    QuantizedHeightField quantized(heightMap);
+    heightMap.clear();
+
+    std::mt19937 random(31);
+    std::uniform_real_distribution<float> coordinate(0.0f, size - 1.001f);
+    std::uniform_real_distribution<float> nearby(1000.0f, 2024.0f);
+    vector<float> xs(queryCount), ys(queryCount), groupXs(queryCount), groupYs(queryCount), floatHeights(queryCount), quantizedHeights(queryCount);
+    for (size_t i = 0; i < queryCount; ++i) {
+        xs[i] = coordinate(random);
+        ys[i] = coordinate(random);
+        groupXs[i] = nearby(random);
+        groupYs[i] = nearby(random);
+    }
+
+    cout << endl << "Quantized 16 bit storage (" << size << "x" << size << " map, " << queryCount << " random queries, documented tolerance "
+         << quantized.getQuantizationTolerance() << ")" << endl;
+    cout << "  memory: double " << exact.memoryUsage() / (1024 * 1024) << " MB, float " << floats.memoryUsage() / (1024 * 1024)
+         << " MB, 16 bit " << quantized.memoryUsage() / (1024 * 1024) << " MB" << endl;
+
+    double checksum = 0;
+    auto t0 = std::chrono::high_resolution_clock::now();
+    for (size_t i = 0; i < queryCount; ++i) checksum += getExactHeight(exact, xs[i], ys[i]);
+    auto t1 = std::chrono::high_resolution_clock::now();
+    for (size_t i = 0; i < queryCount; ++i) checksum -= quantized.getExactHeight(xs[i], ys[i]);
+    auto t2 = std::chrono::high_resolution_clock::now();
+    getExactHeights(floats, xs.data(), ys.data(), floatHeights.data(), queryCount);
+    auto t3 = std::chrono::high_resolution_clock::now();
+    getExactHeights(quantized, xs.data(), ys.data(), quantizedHeights.data(), queryCount);
+    auto t4 = std::chrono::high_resolution_clock::now();
+
+    double maxSingleError = 0, maxBatchError = 0;
+    for (size_t i = 0; i < queryCount; ++i) {
+        double reference = getExactHeight(exact, xs[i], ys[i]);
+        maxSingleError = std::max(maxSingleError, std::abs(quantized.getExactHeight(xs[i], ys[i]) - reference));
+        maxBatchError = std::max(maxBatchError, std::abs(quantizedHeights[i] - reference));
+    }
+
+    auto ns = [&](std::chrono::high_resolution_clock::time_point a, std::chrono::high_resolution_clock::time_point b) {
+        return std::chrono::duration<double, std::nano>(b - a).count() / queryCount;
+    };
+    cout << "  single query: double " << ns(t0, t1) << " ns, 16 bit " << ns(t1, t2) << " ns (max error " << maxSingleError << ", checksum " << checksum << ")" << endl;
+
+    // queries inside a 1024x1024 area: 2 MB of 16 bit samples against 8 MB of doubles
+    auto g0 = std::chrono::high_resolution_clock::now();
+    for (size_t i = 0; i < queryCount; ++i) checksum += getExactHeight(exact, groupXs[i], groupYs[i]);
+    auto g1 = std::chrono::high_resolution_clock::now();
+    for (size_t i = 0; i < queryCount; ++i) checksum -= quantized.getExactHeight(groupXs[i], groupYs[i]);
+    auto g2 = std::chrono::high_resolution_clock::now();
+    cout << "  grouped:      double " << ns(g0, g1) << " ns, 16 bit " << ns(g1, g2) << " ns (checksum " << checksum << ")" << endl;
+    cout << "  batch:        float " << ns(t2, t3) << " ns, 16 bit " << ns(t3, t4) << " ns (max error " << maxBatchError << ")" << endl;
+
+    std::uniform_real_distribution<float> angle(0.0f, 6.2831853f);
+    vector<Vector3> origins(rayCount), directions(rayCount);
+    for (size_t i = 0; i < rayCount; ++i) {
+        float a = angle(random);
+        origins[i] = Vector3(coordinate(random), coordinate(random), 80.0f);
+        directions[i] = Vector3(std::cos(a), std::sin(a), -0.2f);
+    }
+    size_t differentHits = 0;
+    double maxDistanceError = 0;
+    auto r0 = std::chrono::high_resolution_clock::now();
+    vector<HeightFieldHit> exactHits(rayCount), quantizedHits(rayCount);
+    vector<char> exactFlags(rayCount), quantizedFlags(rayCount);
+    for (size_t i = 0; i < rayCount; ++i) exactFlags[i] = raycast(exact, origins[i], directions[i], 10000.0f, exactHits[i]);
+    auto r1 = std::chrono::high_resolution_clock::now();
+    for (size_t i = 0; i < rayCount; ++i) quantizedFlags[i] = raycast(quantized, origins[i], directions[i], 10000.0f, quantizedHits[i]);
+    auto r2 = std::chrono::high_resolution_clock::now();
+    for (size_t i = 0; i < rayCount; ++i) {
+        if (exactFlags[i] != quantizedFlags[i]) ++differentHits;
+        else if (exactFlags[i]) maxDistanceError = std::max(maxDistanceError, static_cast<double>(std::abs(exactHits[i].distance - quantizedHits[i].distance)));
+    }
+    cout << "  ray casts:    double " << rayCount / std::chrono::duration<double>(r1 - r0).count() / 1e6 << " M rays/s, 16 bit "
+         << rayCount / std::chrono::duration<double>(r2 - r1).count() / 1e6 << " M rays/s (" << differentHits << " different hits, max hit distance difference "
+         << maxDistanceError << ")" << endl;
+
+    // widen one tile 20 times; every decoded sample has to stay within the reported tolerance of the height it was set to
+    vector<vector<double>> small(16, vector<double>(16));
+    for (size_t x = 0; x < 16; ++x)
+        for (size_t y = 0; y < 16; ++y) small[x][y] = std::sin(0.7 * x) * std::cos(0.3 * y) * 5.0;
+    QuantizedHeightField edited(small);
+    for (int edit = 1; edit <= 20; ++edit) {
+        small[edit % 8][(edit * 3) % 8] = 5.0 + edit * 7.3;
+        edited.set(edit % 8, (edit * 3) % 8, static_cast<float>(small[edit % 8][(edit * 3) % 8]));
+    }
+    double maxEditError = 0;
+    for (size_t x = 0; x < 16; ++x)
+        for (size_t y = 0; y < 16; ++y) maxEditError = std::max(maxEditError, std::abs(edited.get(x, y) - small[x][y]));
+    cout << "  20 widening edits: max error " << maxEditError << ", reported tolerance " << edited.getQuantizationTolerance()
+         << (maxEditError <= edited.getQuantizationTolerance() * 1.001 + 1e-5 ? "" : " EXCEEDED") << endl;
+}
+
 int main()
 {
     // Example height map (5x5 grid)
@@ -130,5 +707,27 @@ int main()
     double exactHeight = getExactHeight(heightMap, x, y);
 
     std::cout << "Exact height at (" << x << ", " << y << ") = " << exactHeight << std::endl;
+
+    Vector3 surfacePoint = getSurfacePoint(heightMap, Vector2(3.5f, 0.25f));
+    std::cout << "Surface point at (3.5, 0.25) = "; surfacePoint.print();
+
+    // The same map in contiguous, cache tiled storage gives the same heights
+    HeightField<double> heightField(heightMap);
+    std::cout << "Exact height at (" << x << ", " << y << ") from HeightField = " << getExactHeight(heightField, x, y) << std::endl;
+
+    runHeightFieldBenchmarks();
+    // A ray dropped straight down lands on the same height getExactHeight returns
+    HeightFieldHit hit;
+    if (raycast(heightField, Vector3(1.3f, 2.7f, 20.0f), Vector3(0.0f, 0.0f, -1.0f), 100.0f, hit)) {
+        std::cout << "Ray hit at "; hit.point.print();
+        std::cout << "Surface normal "; hit.normal.print();
+    }
+
+    runBatchHeightBenchmarks();
+    runRaycastBenchmarks();
+    runPyramidBenchmarks();
+    runPlaneCacheBenchmarks();
+    runQuantizedBenchmarks();
+    runPagedTerrainBenchmarks();
     return 0;
 }
@@ -0,0 +1,155 @@
+// Catmull-Rom spline over points of any dimension and scalar type, with uniform, centripetal or chordal parameterization
+//
+// The alpha parameter sets how far apart the knots of neighbouring points are: t[i + 1] = t[i] + |P[i + 1] - P[i]|^alpha
+//   0   uniform     - catmullRom from Question7&8.cpp, overshoots and can form cusps / loops when the points are unevenly spaced
+//   0.5 centripetal - never forms cusps or self intersections inside a segment, follows the points most tightly
+//   1   chordal     - rounder curves, swings wider around sharp corners
+// For the segment P1 -> P2 the non-uniform curve is the cubic Hermite between P1 and P2 with the tangents
+//   m1 = (t2 - t1) * ((P1 - P0) / (t1 - t0) - (P2 - P0) / (t2 - t0) + (P2 - P1) / (t2 - t1))
+//   m2 = (t2 - t1) * ((P2 - P1) / (t2 - t1) - (P3 - P1) / (t3 - t1) + (P3 - P2) / (t3 - t2))
+// (the Barry-Goldman pyramid differentiated at its ends, rescaled to u in [0, 1]), which for alpha 0 is exactly
+// (P2 - P0) / 2 and (P3 - P1) / 2. The cubic is expanded into coefficients once per segment, so evaluating a centripetal
+// or chordal spline costs the same three multiply-adds per component as a uniform one.
+
+#pragma once
+
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+
+enum class SplineEnds { Phantom, Duplicate, Closed };
+
+template <std::size_t Dimension, typename Scalar>
+using SplineVector = std::array<Scalar, Dimension>;
+
+// P(u) = c[0] + c[1] * u + c[2] * u^2 + c[3] * u^3 for u in [0, 1]
+template <std::size_t Dimension, typename Scalar>
+struct CatmullRomSegment {
+    typedef SplineVector<Dimension, Scalar> Vector;
+
+    Vector c[4];
+
+    Vector evaluate(Scalar u) const {
+        Vector p;
+        for (std::size_t i = 0; i < Dimension; ++i)
+            p[i] = c[0][i] + u * (c[1][i] + u * (c[2][i] + u * c[3][i]));
+        return p;
+    }
+
+    // dP/du
+    Vector derivative(Scalar u) const {
+        Vector v;
+        for (std::size_t i = 0; i < Dimension; ++i)
+            v[i] = c[1][i] + u * (2 * c[2][i] + u * 3 * c[3][i]);
+        return v;
+    }
+};
+
+// Coefficients of the segment P1 -> P2 with the given alpha
+template <std::size_t Dimension, typename Scalar>
+CatmullRomSegment<Dimension, Scalar> makeCatmullRomSegment(const SplineVector<Dimension, Scalar>& P0, const SplineVector<Dimension, Scalar>& P1,
+                                                           const SplineVector<Dimension, Scalar>& P2, const SplineVector<Dimension, Scalar>& P3, Scalar alpha) {
+    // knot intervals |P[i + 1] - P[i]|^alpha, done in double so float splines get the same tangents
+    auto interval = [alpha](const SplineVector<Dimension, Scalar>& a, const SplineVector<Dimension, Scalar>& b) {
+        if (alpha == 0) return 1.0;
+        double lengthSquared = 0;
+        for (std::size_t i = 0; i < Dimension; ++i)
+            lengthSquared += (static_cast<double>(b[i]) - a[i]) * (static_cast<double>(b[i]) - a[i]);
+        double knot = std::pow(lengthSquared, 0.5 * alpha);
+        // two points on top of each other: their difference is 0, any interval keeps the tangent finite
+        return knot > 0 ? knot : 1.0;
+    };
+    double d0 = interval(P0, P1), d1 = interval(P1, P2), d2 = interval(P2, P3);
+
+    CatmullRomSegment<Dimension, Scalar> segment;
+    for (std::size_t i = 0; i < Dimension; ++i) {
+        double p0 = P0[i], p1 = P1[i], p2 = P2[i], p3 = P3[i];
+        double m1 = d1 * ((p1 - p0) / d0 - (p2 - p0) / (d0 + d1) + (p2 - p1) / d1);
+        double m2 = d1 * ((p2 - p1) / d1 - (p3 - p1) / (d1 + d2) + (p3 - p2) / d2);
+
+        // Hermite basis grouped by powers of u
+        segment.c[0][i] = static_cast<Scalar>(p1);
+        segment.c[1][i] = static_cast<Scalar>(m1);
+        segment.c[2][i] = static_cast<Scalar>(-3 * p1 + 3 * p2 - 2 * m1 - m2);
+        segment.c[3][i] = static_cast<Scalar>(2 * p1 - 2 * p2 + m1 + m2);
+    }
+    return segment;
+}
+
+// A spline through all of the points, every segment gets the same share of the time t in [0, 1]
+// (the end segments use the same phantom / duplicate / closed neighbours as SplinePath)
+template <std::size_t Dimension, typename Scalar>
+class CatmullRomSpline {
+public:
+    typedef SplineVector<Dimension, Scalar> Vector;
+    typedef CatmullRomSegment<Dimension, Scalar> Segment;
+
+private:
+    std::vector<Vector> points;
+    std::vector<Segment> segments;
+    Scalar alpha;
+    SplineEnds ends;
+
+    Vector controlPoint(std::ptrdiff_t i) const {
+        std::ptrdiff_t count = static_cast<std::ptrdiff_t>(points.size());
+        if (ends == SplineEnds::Closed) return points[(i % count + count) % count];
+        if (i >= 0 && i < count) return points[i];
+        std::size_t end = i < 0 ? 0 : count - 1, neighbour = i < 0 ? 1 : count - 2;
+        if (ends == SplineEnds::Duplicate) return points[end];
+        Vector mirrored;
+        for (std::size_t k = 0; k < Dimension; ++k) mirrored[k] = 2 * points[end][k] - points[neighbour][k];
+        return mirrored;
+    }
+
+public:
+    // alpha 0 is uniform, 0.5 centripetal and 1 chordal. Needs at least 2 points (3 for a closed spline)
+    explicit CatmullRomSpline(const std::vector<Vector>& points, Scalar alpha = Scalar(0.5), SplineEnds ends = SplineEnds::Phantom)
+        : points(points), alpha(alpha), ends(ends) {
+        if (points.size() < (ends == SplineEnds::Closed ? 3u : 2u))
+            throw std::invalid_argument("A spline path needs at least 2 points (3 if it is closed).");
+
+        std::size_t segmentCount = ends == SplineEnds::Closed ? points.size() : points.size() - 1;
+        segments.reserve(segmentCount);
+        for (std::size_t i = 0; i < segmentCount; ++i) {
+            std::ptrdiff_t p = static_cast<std::ptrdiff_t>(i);
+            segments.push_back(makeCatmullRomSegment<Dimension, Scalar>(controlPoint(p - 1), controlPoint(p), controlPoint(p + 1), controlPoint(p + 2), alpha));
+        }
+    }
+
+    std::size_t getPointCount() const { return points.size(); }
+    std::size_t getSegmentCount() const { return segments.size(); }
+    const std::vector<Vector>& getPoints() const { return points; }
+    const Segment& getSegment(std::size_t segment) const { return segments[segment]; }
+    Scalar getAlpha() const { return alpha; }
+
+    // Segment the time t falls in and the time u in [0, 1] inside it (t is clamped to [0, 1])
+    std::size_t findSegment(Scalar t, Scalar& u) const {
+        t = std::min(std::max(t, Scalar(0)), Scalar(1));
+        std::size_t count = segments.size();
+        std::size_t segment = std::min(static_cast<std::size_t>(t * count), count - 1);
+        u = std::min(t * count - segment, Scalar(1));
+        return segment;
+    }
+
+    // Point at time t in [0, 1], passing through points[i] at t == i / getSegmentCount()
+    Vector getPoint(Scalar t) const {
+        if (t < 0 || t > 1) {
+            throw std::out_of_range("Time parameter must be in the range [0,1]");
+        }
+        Scalar u;
+        std::size_t segment = findSegment(t, u);
+        return segments[segment].evaluate(u);
+    }
+
+    // dP/dt at time t (t clamped to [0, 1])
+    Vector getTangent(Scalar t) const {
+        Scalar u;
+        std::size_t segment = findSegment(t, u);
+        Vector tangent = segments[segment].derivative(u);
+        for (Scalar& component : tangent) component *= static_cast<Scalar>(segments.size());
+        return tangent;
+    }
+};
@@ -0,0 +1,197 @@
+// Headless rasterizer for curves (the visual output of Question7&8, and image based regression checks of many curves)
+//
+// Everything is drawn into one contiguous RGB buffer. Consecutive samples of a curve are joined with anti-aliased lines
+// (Xiaolin Wu: every step along the major axis covers the two pixels the line passes between, weighted by how close
+// it is to each), so the curve has no gaps however sparse its samples are. Any number of curves in different colours
+// can go into one image. The image is written as a binary PPM (colour) or PGM (grey) file, or turned into ASCII art
+// in a single string, so printing it is one write instead of one per character.
+// The view maps [minX, maxX] x [minY, maxY] onto the image, a range of zero width or height (a vertical or horizontal
+// line, a single point) is widened around its centre instead of dividing by zero.
+
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "SplinePath.h"
+
+struct CurveColor {
+    std::uint8_t r, g, b;
+};
+
+class CurveRasterizer {
+private:
+    int width;
+    int height;
+    std::vector<std::uint8_t> pixels;     // width * height RGB triples, row 0 at the top
+    double minX = 0, minY = 0, maxX = 1, maxY = 1;
+    double scaleX = 1, scaleY = 1;        // image pixels per unit
+
+    // blends color into pixel (x, y) by coverage in [0, 1], pixels outside the image are ignored
+    void plot(int x, int y, CurveColor color, double coverage) {
+        if (x < 0 || y < 0 || x >= width || y >= height || coverage <= 0) return;
+        std::uint8_t* pixel = &pixels[(static_cast<std::size_t>(y) * width + x) * 3];
+        const std::uint8_t channels[3] = { color.r, color.g, color.b };
+        for (int i = 0; i < 3; ++i)
+            pixel[i] = static_cast<std::uint8_t>(pixel[i] + (channels[i] - pixel[i]) * std::min(coverage, 1.0) + 0.5);
+    }
+
+    void updateScale() {
+        // widen an empty range around its centre so a vertical / horizontal line or a single point still maps
+        if (!(maxX > minX)) { double centre = 0.5 * (minX + maxX); minX = centre - 0.5; maxX = centre + 0.5; }
+        if (!(maxY > minY)) { double centre = 0.5 * (minY + maxY); minY = centre - 0.5; maxY = centre + 0.5; }
+        scaleX = (width - 1) / (maxX - minX);
+        scaleY = (height - 1) / (maxY - minY);
+    }
+
+    // Xiaolin Wu's line between two points in image coordinates
+    void drawLine(double x0, double y0, double x1, double y1, CurveColor color) {
+        bool steep = std::abs(y1 - y0) > std::abs(x1 - x0);
+        if (steep) { std::swap(x0, y0); std::swap(x1, y1); }
+        if (x0 > x1) { std::swap(x0, x1); std::swap(y0, y1); }
+
+        double dx = x1 - x0;
+        double gradient = dx > 0 ? (y1 - y0) / dx : 0;
+
+        // (x, y) is the pixel or its transpose for a steep line
+        auto put = [&](int major, int minor, double coverage) {
+            if (steep) plot(minor, major, color, coverage);
+            else plot(major, minor, color, coverage);
+        };
+
+        // end points, weighted by how much of their pixel the line covers along the major axis
+        int start = static_cast<int>(std::floor(x0 + 0.5)), end = static_cast<int>(std::floor(x1 + 0.5));
+        double y = y0 + gradient * (start - x0);
+        double startCover = 1 - (x0 + 0.5 - std::floor(x0 + 0.5));
+        double endCover = x1 + 0.5 - std::floor(x1 + 0.5);
+        if (start == end) {
+            double cover = x1 - x0;
+            double fraction = y - std::floor(y);
+            put(start, static_cast<int>(std::floor(y)), (1 - fraction) * std::max(cover, 0.5));
+            put(start, static_cast<int>(std::floor(y)) + 1, fraction * std::max(cover, 0.5));
+            return;
+        }
+
+        // clip the major axis to the image, the minor axis is clipped per pixel in plot
+        int limit = steep ? height : width;
+        int first = std::max(start, -1), last = std::min(end, limit);
+        y += gradient * (first - start);
+        for (int major = first; major <= last; ++major, y += gradient) {
+            double cover = major == start ? startCover : major == end ? endCover : 1;
+            int minor = static_cast<int>(std::floor(y));
+            double fraction = y - minor;
+            put(major, minor, (1 - fraction) * cover);
+            put(major, minor + 1, fraction * cover);
+        }
+    }
+
+public:
+    CurveRasterizer(int width, int height) : width(width), height(height) {
+        if (width < 2 || height < 2) throw std::invalid_argument("The image must be at least 2x2 pixels.");
+        pixels.assign(static_cast<std::size_t>(width) * height * 3, 0);
+    }
+
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+    const std::uint8_t* data() const { return pixels.data(); }
+
+    // fills the image with one colour (black by default)
+    void clear(CurveColor background = CurveColor{ 0, 0, 0 }) {
+        for (std::size_t i = 0; i < pixels.size(); i += 3) {
+            pixels[i] = background.r;
+            pixels[i + 1] = background.g;
+            pixels[i + 2] = background.b;
+        }
+    }
+
+    // Shows [minX, maxX] x [minY, maxY] (y up)
+    void setView(double viewMinX, double viewMinY, double viewMaxX, double viewMaxY) {
+        minX = viewMinX; minY = viewMinY; maxX = viewMaxX; maxY = viewMaxY;
+        updateScale();
+    }
+
+    // Shows the bounding box of all of the given curves
+    void fitView(const std::vector<const std::vector<Point>*>& curves) {
+        bool empty = true;
+        for (const std::vector<Point>* curve : curves) {
+            for (const Point& p : *curve) {
+                if (empty) { minX = maxX = p.x; minY = maxY = p.y; empty = false; }
+                minX = std::min(minX, p.x); maxX = std::max(maxX, p.x);
+                minY = std::min(minY, p.y); maxY = std::max(maxY, p.y);
+            }
+        }
+        if (empty) { minX = minY = 0; maxX = maxY = 1; }
+        updateScale();
+    }
+
+    // Joins the count points with anti-aliased lines
+    void drawCurve(const Point* points, std::size_t count, CurveColor color = CurveColor{ 255, 255, 255 }) {
+        auto toImage = [&](const Point& p, double& x, double& y) {
+            x = (p.x - minX) * scaleX;
+            y = (height - 1) - (p.y - minY) * scaleY;      // flip y so up is up
+        };
+        double x0, y0, x1, y1;
+        if (count == 1) {
+            toImage(points[0], x0, y0);
+            drawLine(x0, y0, x0, y0, color);
+            return;
+        }
+        for (std::size_t i = 0; i + 1 < count; ++i) {
+            toImage(points[i], x0, y0);
+            toImage(points[i + 1], x1, y1);
+            // skip pieces that are entirely outside the image
+            if (std::max(x0, x1) < -1 || std::min(x0, x1) > width || std::max(y0, y1) < -1 || std::min(y0, y1) > height) continue;
+            drawLine(x0, y0, x1, y1, color);
+        }
+    }
+
+    void drawCurve(const std::vector<Point>& curve, CurveColor color = CurveColor{ 255, 255, 255 }) {
+        if (!curve.empty()) drawCurve(curve.data(), curve.size(), color);
+    }
+
+    // brightness of a pixel, 0 to 255
+    std::uint8_t getGrey(int x, int y) const {
+        const std::uint8_t* pixel = &pixels[(static_cast<std::size_t>(y) * width + x) * 3];
+        return static_cast<std::uint8_t>((pixel[0] * 77 + pixel[1] * 150 + pixel[2] * 29) >> 8);
+    }
+
+    // The image as ASCII art, one character per pixel from ' ' (dark) to '@' (bright), rows ending in '\n'
+    std::string toAscii() const {
+        static const char ramp[] = " .:-=+*#%@";
+        std::string text;
+        text.resize(static_cast<std::size_t>(width + 1) * height);
+        char* out = &text[0];
+        for (int y = 0; y < height; ++y) {
+            for (int x = 0; x < width; ++x) *out++ = ramp[getGrey(x, y) * 9 / 255];
+            *out++ = '\n';
+        }
+        return text;
+    }
+
+    // Binary PPM (P6) with the colours, returns false if the file could not be written
+    bool writePPM(const std::string& path) const {
+        return writeImage(path, "P6", pixels.data(), pixels.size());
+    }
+
+    // Binary PGM (P5) with the brightness
+    bool writePGM(const std::string& path) const {
+        std::vector<std::uint8_t> grey(static_cast<std::size_t>(width) * height);
+        for (int y = 0; y < height; ++y)
+            for (int x = 0; x < width; ++x) grey[static_cast<std::size_t>(y) * width + x] = getGrey(x, y);
+        return writeImage(path, "P5", grey.data(), grey.size());
+    }
+
+private:
+    bool writeImage(const std::string& path, const char* magic, const std::uint8_t* data, std::size_t size) const {
+        std::FILE* file = std::fopen(path.c_str(), "wb");
+        if (!file) return false;
+        bool written = std::fprintf(file, "%s\n%d %d\n255\n", magic, width, height) > 0 && std::fwrite(data, 1, size, file) == size;
+        return std::fclose(file) == 0 && written;
+    }
+};
@@ -8,13 +8,21 @@
 #include <iostream>
 #include <vector>
 #include <cmath>
+#include <chrono>
+#include <random>
+#include <algorithm>
+#include <limits>
+#include <sstream>
+#include <filesystem>
 
-using namespace std;
+#include "SplinePath.h"
+#include "SplineArcLength.h"
+#include "SplineTessellation.h"
+#include "SplineCursor.h"
+#include "SplineBVH.h"
+#include "CurveRasterizer.h"
 
-// Represents a 2D point in space.
-struct Point {
-    double x, y;
-};
+using namespace std;
 
 // I am using catmull-rom spline for this implementation instead of brezier curves
 // https://qroph.github.io/2018/07/30/smooth-paths-using-catmull-rom-splines.html
@@ -63,40 +71,586 @@ Point getPointOnCurve(const Point& P0, const Point& P1, const Point& P2, const P
     return catmullRom(P0, P1, P2, P3, time);
 }
 
+// Draws the curve as ASCII art, the samples joined by anti-aliased lines and printed with a single write
 void plotCurve(const vector<Point>& curve) {
     const int width = 80;  // Grid width (columns)
     const int height = 80; // Grid height (rows)
+    if (curve.empty()) return;
+
+    CurveRasterizer image(width, height);
+    image.fitView({ &curve });
+    image.drawCurve(curve);
+    cout << image.toAscii();
+}
+
+// ---------------------------------------------------------------------------------------------
+// Benchmarks
+// ---------------------------------------------------------------------------------------------
+
+// Winding test path of count points, roughly like an enemy patrol route
+vector<Point> makeTestPath(size_t count, unsigned seed) {
+    std::mt19937 random(seed);
+    std::uniform_real_distribution<double> jitter(-0.25, 0.25);
+    vector<Point> points(count);
+    for (size_t i = 0; i < count; ++i) {
+        double angle = 0.05 * i;
+        points[i] = { i * 2.0 + 3 * std::sin(angle) + jitter(random), 10 * std::cos(angle * 0.7) + jitter(random) };
+    }
+    return points;
+}
+
+// Path time -> point, by picking the four points around the segment and calling catmullRom every time (what a caller
+// had to do before SplinePath), with the same phantom end points and uniform spacing
+Point getPointOnPath(const vector<Point>& points, double t) {
+    size_t segmentCount = points.size() - 1;
+    size_t segment = std::min(static_cast<size_t>(t * segmentCount), segmentCount - 1);
+    auto at = [&](std::ptrdiff_t i) -> Point {
+        std::ptrdiff_t last = static_cast<std::ptrdiff_t>(points.size()) - 1;
+        if (i < 0) return { 2 * points[0].x - points[1].x, 2 * points[0].y - points[1].y };
+        if (i > last) return { 2 * points[last].x - points[last - 1].x, 2 * points[last].y - points[last - 1].y };
+        return points[i];
+    };
+    std::ptrdiff_t i = static_cast<std::ptrdiff_t>(segment);
+    return catmullRom(at(i - 1), at(i), at(i + 1), at(i + 2), t * segmentCount - segment);
+}
+
+void runSplinePathBenchmarks() {
+    const size_t queryCount = 2000000;
+
+    std::mt19937 random(5);
+    std::uniform_real_distribution<double> time(0.0, 1.0);
+    vector<double> times(queryCount);
+    for (double& t : times) t = time(random);
+
+    cout << endl << "Spline path evaluation (" << queryCount << " random times)" << endl;
+    for (size_t pointCount : { 16, 256, 4096 }) {
+        vector<Point> points = makeTestPath(pointCount, 7);
+        SplinePath path(points);
+        SplinePath chordPath(points, SplineEnds::Phantom, SplineSpacing::ChordLength);
+
+        double checksum = 0, maxDifference = 0;
+        auto t0 = std::chrono::high_resolution_clock::now();
+        for (double t : times) checksum += getPointOnPath(points, t).x;
+        auto t1 = std::chrono::high_resolution_clock::now();
+        for (double t : times) checksum -= path.getPoint(t).x;
+        auto t2 = std::chrono::high_resolution_clock::now();
+        for (double t : times) checksum += chordPath.getPoint(t).x;
+        auto t3 = std::chrono::high_resolution_clock::now();
+
+        for (size_t i = 0; i < queryCount; i += 64) {
+            Point a = getPointOnPath(points, times[i]), b = path.getPoint(times[i]);
+            maxDifference = std::max(maxDifference, std::max(std::abs(a.x - b.x), std::abs(a.y - b.y)));
+        }
+
+        auto ns = [&](std::chrono::high_resolution_clock::time_point a, std::chrono::high_resolution_clock::time_point b) {
+            return std::chrono::duration<double, std::nano>(b - a).count() / queryCount;
+        };
+        cout << "  " << pointCount << " points: catmullRom per query " << ns(t0, t1) << " ns, SplinePath " << ns(t1, t2)
+             << " ns, chord length spacing " << ns(t2, t3) << " ns (max difference " << maxDifference << ", checksum " << checksum << ")" << endl;
+    }
+}
+
+// Agents moving along one shared path at the same speed: stepping the path time t by a fixed amount against stepping
+// the distance through the arc length table, reports ns per agent and how much the actual speed varies
+void runArcLengthBenchmarks() {
+    const size_t agentCount = 5000;
+    const int frames = 200;
+
+    SplinePath path(makeTestPath(256, 9));
+    auto start = std::chrono::high_resolution_clock::now();
+    SplineArcLengthTable table(path);
+    auto end = std::chrono::high_resolution_clock::now();
+
+    double length = table.getLength();
+    double speed = length / 1000;   // every agent covers the path in 1000 frames
+    vector<double> times(agentCount), distances(agentCount);
+    vector<Point> uniformPoints(agentCount), constantPoints(agentCount), previousUniform(agentCount), previousConstant(agentCount);
+    for (size_t i = 0; i < agentCount; ++i) {
+        distances[i] = length * i / agentCount;
+        times[i] = table.getTime(distances[i]);
+        previousUniform[i] = path.getPoint(times[i]);
+        previousConstant[i] = table.getPoint(distances[i]);
+    }
+
+    // smallest and largest distance moved in one frame, relative to the wanted speed
+    double uniformMin = 1e30, uniformMax = 0, constantMin = 1e30, constantMax = 0;
+    double uniformTime = 0, constantTime = 0;
+    for (int frame = 0; frame < frames; ++frame) {
+        for (size_t i = 0; i < agentCount; ++i) {
+            times[i] = std::fmod(times[i] + 0.001, 1.0);
+            distances[i] = std::fmod(distances[i] + speed, length);
+        }
+
+        auto t0 = std::chrono::high_resolution_clock::now();
+        for (size_t i = 0; i < agentCount; ++i) uniformPoints[i] = path.getPoint(times[i]);
+        auto t1 = std::chrono::high_resolution_clock::now();
+        table.getPoints(distances.data(), constantPoints.data(), agentCount);
+        auto t2 = std::chrono::high_resolution_clock::now();
+        uniformTime += std::chrono::duration<double, std::nano>(t1 - t0).count();
+        constantTime += std::chrono::duration<double, std::nano>(t2 - t1).count();
+
+        for (size_t i = 0; i < agentCount; ++i) {
+            // skip the agents that just wrapped around to the start
+            double moved = std::hypot(uniformPoints[i].x - previousUniform[i].x, uniformPoints[i].y - previousUniform[i].y) / speed;
+            if (moved < 2) { uniformMin = std::min(uniformMin, moved); uniformMax = std::max(uniformMax, moved); }
+            moved = std::hypot(constantPoints[i].x - previousConstant[i].x, constantPoints[i].y - previousConstant[i].y) / speed;
+            if (moved < 2) { constantMin = std::min(constantMin, moved); constantMax = std::max(constantMax, moved); }
+        }
+        previousUniform.swap(uniformPoints);
+        previousConstant.swap(constantPoints);
+    }
+
+    cout << endl << "Arc length table (256 point path, length " << length << ", " << table.memoryUsage() / 1024 << " KB, built in "
+         << std::chrono::duration<double, std::micro>(end - start).count() << " us)" << endl;
+    cout << "  " << agentCount << " agents x " << frames << " frames: fixed t step " << uniformTime / (agentCount * frames)
+         << " ns per agent, speed " << uniformMin << "x to " << uniformMax << "x" << endl;
+    cout << "  constant speed: " << constantTime / (agentCount * frames) << " ns per agent, speed " << constantMin << "x to " << constantMax << "x" << endl;
+}
+
+// Thousands of 4 point curves (trails) tessellated every frame: generateSmoothCurve against writing into one buffer
+void runTessellationBenchmarks() {
+    const size_t curveCount = 4096;
+    const int numSamples = 64;
+
+    std::mt19937 random(11);
+    std::uniform_real_distribution<double> coordinate(-100.0, 100.0);
+    vector<Point> controls(curveCount * 4);
+    for (Point& p : controls) p = { coordinate(random), coordinate(random) };
+    vector<SplinePath::Segment> segments(curveCount);
+    for (size_t i = 0; i < curveCount; ++i)
+        segments[i] = SplinePath::makeSegment(controls[4 * i], controls[4 * i + 1], controls[4 * i + 2], controls[4 * i + 3]);
+
+    vector<Point> buffer(curveCount * SplineTessellation::segmentPointCount(numSamples));
+    double checksum = 0;
+    auto samplesPerSecond = [&](std::chrono::high_resolution_clock::time_point a, std::chrono::high_resolution_clock::time_point b) {
+        return curveCount * (numSamples + 1) / std::chrono::duration<double>(b - a).count() / 1e6;
+    };
+
+    // the buffer is written once untimed, so no variant pays for faulting it in
+    for (size_t i = 0; i < curveCount; ++i)
+        SplineTessellation::horner(segments[i], numSamples, &buffer[i * (numSamples + 1)]);
+
+    auto t0 = std::chrono::high_resolution_clock::now();
+    for (size_t i = 0; i < curveCount; ++i)
+        SplineTessellation::forwardDifference(segments[i], numSamples, &buffer[i * (numSamples + 1)]);
+    auto t1 = std::chrono::high_resolution_clock::now();
+    for (size_t i = 0; i < curveCount; ++i)
+        SplineTessellation::horner(segments[i], numSamples, &buffer[i * (numSamples + 1)]);
+    auto t2 = std::chrono::high_resolution_clock::now();
+    for (size_t i = 0; i < curveCount; ++i)
+        tessellateCurve(controls[4 * i], controls[4 * i + 1], controls[4 * i + 2], controls[4 * i + 3], numSamples, &buffer[i * (numSamples + 1)]);
+    auto t3 = std::chrono::high_resolution_clock::now();
+    for (size_t i = 0; i < curveCount; ++i)
+        checksum += generateSmoothCurve(controls[4 * i], controls[4 * i + 1], controls[4 * i + 2], controls[4 * i + 3], numSamples).back().x;
+    auto t4 = std::chrono::high_resolution_clock::now();
+
+    // every variant against generateSmoothCurve
+    double maxForward = 0, maxHorner = 0;
+    vector<Point> forward(numSamples + 1);
+    for (size_t i = 0; i < curveCount; i += 16) {
+        vector<Point> curve = generateSmoothCurve(controls[4 * i], controls[4 * i + 1], controls[4 * i + 2], controls[4 * i + 3], numSamples);
+        SplineTessellation::forwardDifference(segments[i], numSamples, forward.data());
+        for (int j = 0; j <= numSamples; ++j) {
+            const Point& h = buffer[i * (numSamples + 1) + j];
+            maxForward = std::max(maxForward, std::max(std::abs(forward[j].x - curve[j].x), std::abs(forward[j].y - curve[j].y)));
+            maxHorner = std::max(maxHorner, std::max(std::abs(h.x - curve[j].x), std::abs(h.y - curve[j].y)));
+        }
+    }
+
+    cout << endl << "Tessellation (" << curveCount << " curves x " << numSamples + 1 << " points, million samples per second)" << endl;
+    cout << "  generateSmoothCurve " << samplesPerSecond(t3, t4) << ", tessellateCurve " << samplesPerSecond(t2, t3)
+         << ", forward differencing " << samplesPerSecond(t0, t1) << ", horner " << samplesPerSecond(t1, t2) << endl;
+    cout << "  max difference: forward differencing " << maxForward << ", horner " << maxHorner << " (checksum " << checksum << ")" << endl;
+}
+
+// Largest distance between the path and the polyline through points, where times[i] is the path time of points[i]
+// (the curve between two points is sampled densely and measured against their chord)
+double measureChordError(const SplinePath& path, const vector<Point>& points, const vector<double>& times) {
+    double maxError = 0;
+    for (size_t i = 0; i + 1 < points.size(); ++i) {
+        Point a = points[i], b = points[i + 1];
+        double cx = b.x - a.x, cy = b.y - a.y, lengthSquared = cx * cx + cy * cy;
+        for (int k = 1; k < 32; ++k) {
+            Point p = path.getPoint(times[i] + (times[i + 1] - times[i]) * k / 32);
+            double along = lengthSquared > 0 ? std::min(std::max(((p.x - a.x) * cx + (p.y - a.y) * cy) / lengthSquared, 0.0), 1.0) : 0;
+            maxError = std::max(maxError, std::hypot(p.x - a.x - along * cx, p.y - a.y - along * cy));
+        }
+    }
+    return maxError;
+}
+
+// Patrol route with long straight runs and a few tight turns
+vector<Point> makeCorneredPath() {
+    vector<Point> points;
+    for (int lap = 0; lap < 8; ++lap) {
+        double y = lap * 6.0;
+        for (int i = 0; i <= 20; ++i) points.push_back({ lap % 2 ? 40.0 - 2 * i : 2.0 * i, y + (i == 10 ? 0.5 : 0.0) });
+    }
+    return points;
+}
+
+// Adaptive tessellation against the number of uniform samples per segment needed for the same chord error, and a
+// check that no chord of the adaptive result is further from the path than the tolerance
+void runAdaptiveTessellationBenchmarks() {
+    cout << endl << "Adaptive tessellation (points for the same chord error as uniform samples per segment)" << endl;
+
+    struct TestPath { const char* name; vector<Point> points; };
+    TestPath paths[] = { { "winding ", makeTestPath(256, 9) }, { "cornered", makeCorneredPath() } };
+    for (const TestPath& test : paths) {
+        SplinePath path(test.points);
+        for (double tolerance : { 0.1, 0.01, 0.001 }) {
+            // first call with no room just counts, then the buffer is sized once
+            size_t needed = tessellatePathAdaptive(path, tolerance, nullptr, 0);
+            vector<Point> adaptive(needed);
+            vector<double> adaptiveTimes(needed);
+            auto start = std::chrono::high_resolution_clock::now();
+            tessellatePathAdaptive(path, tolerance, adaptive.data(), adaptive.size(), adaptiveTimes.data());
+            auto end = std::chrono::high_resolution_clock::now();
+            double adaptiveError = measureChordError(path, adaptive, adaptiveTimes);
+
+            // fewest uniform samples per segment that reach the same chord error (doubling, then bisecting)
+            auto uniformReaches = [&](int samples) {
+                vector<Point> uniform(SplineTessellation::pathPointCount(path, samples));
+                vector<double> uniformTimes(uniform.size());
+                tessellatePath(path, samples, uniform.data());
+                for (size_t i = 0; i < uniform.size(); ++i) uniformTimes[i] = static_cast<double>(i) / (uniform.size() - 1);
+                return measureChordError(path, uniform, uniformTimes) <= adaptiveError;
+            };
+            int samples = 1;
+            while (samples < 4096 && !uniformReaches(samples)) samples *= 2;
+            for (int low = samples / 2 + 1, high = samples; low < high;) {
+                int middle = (low + high) / 2;
+                if (uniformReaches(middle)) high = middle; else low = middle + 1;
+                samples = high;
+            }
+            size_t uniformCount = SplineTessellation::pathPointCount(path, samples);
+
+            cout << "  " << test.name << " tolerance " << tolerance << ": " << needed << " points in " << std::chrono::duration<double, std::micro>(end - start).count()
+                 << " us (measured error " << adaptiveError << (adaptiveError <= tolerance ? ", within tolerance" : ", TOLERANCE EXCEEDED")
+                 << "), uniform needs " << uniformCount << " (" << samples << " per segment, " << static_cast<double>(uniformCount) / needed << "x)" << endl;
+        }
+    }
+}
+
+// Position, tangent and curvature the way a caller gets them without a cursor: locate the segment again every frame
+SplineFrame evaluateFrame(const SplinePath& path, double t) {
+    double u;
+    const SplinePath::Segment& segment = path.getSegment(path.findSegment(t, u));
+    Point position = path.getPoint(t), velocity = segment.derivative(u), acceleration = segment.secondDerivative(u);
+    double speed = std::hypot(velocity.x, velocity.y);
+    return { position, { velocity.x / speed, velocity.y / speed }, (velocity.x * acceleration.y - velocity.y * acceleration.x) / (speed * speed * speed) };
+}
+
+// 20000 objects on closed paths, every frame: t += dt and a fresh lookup against cursors advanced in place
+void runCursorBenchmarks() {
+    const size_t cursorCount = 20000;
+    const int frames = 200;
+
+    vector<Point> points = makeTestPath(256, 13);
+    points.push_back({ points.back().x / 2, -30 });   // back to the start, so the loop closes smoothly
+    SplinePath path(points, SplineEnds::Closed);
+    SplineArcLengthTable table(path);
 
-    // Find min and max coordinates
+    vector<double> times(cursorCount), distances(cursorCount);
+    vector<SplineCursor> timeCursors, distanceCursors, threadedCursors;
+    timeCursors.reserve(cursorCount);
+    distanceCursors.reserve(cursorCount);
+    threadedCursors.reserve(cursorCount);
+    for (size_t i = 0; i < cursorCount; ++i) {
+        times[i] = static_cast<double>(i) / cursorCount;
+        distances[i] = table.getLength() * i / cursorCount;
+        timeCursors.emplace_back(path, times[i]);
+        distanceCursors.emplace_back(table, distances[i]);
+        threadedCursors.emplace_back(table, distances[i]);
+    }
+    vector<SplineFrame> lookupFrames(cursorCount), cursorFrames(cursorCount), threadedFrames(cursorCount);
+    const double dt = 0.0003, step = table.getLength() * dt;
+
+    WorkerPool workers;     // started once, not every frame
+    double lookupTime = 0, cursorTime = 0, lookupDistanceTime = 0, cursorDistanceTime = 0, threadedTime = 0;
+    double maxDifference = 0;
+    bool threadedSame = true;
+    for (int frame = 0; frame < frames; ++frame) {
+        auto t0 = std::chrono::high_resolution_clock::now();
+        for (size_t i = 0; i < cursorCount; ++i) {
+            times[i] = std::fmod(times[i] + dt, 1.0);
+            lookupFrames[i] = evaluateFrame(path, times[i]);
+        }
+        auto t1 = std::chrono::high_resolution_clock::now();
+        advanceCursors(timeCursors.data(), cursorCount, dt, false, cursorFrames.data());
+        auto t2 = std::chrono::high_resolution_clock::now();
+        for (size_t i = 0; i < cursorCount; ++i) {
+            distances[i] = std::fmod(distances[i] + step, table.getLength());
+            lookupFrames[i] = evaluateFrame(path, table.getTime(distances[i]));
+        }
+        auto t3 = std::chrono::high_resolution_clock::now();
+        advanceCursors(distanceCursors.data(), cursorCount, step, true, cursorFrames.data());
+        auto t4 = std::chrono::high_resolution_clock::now();
+        advanceCursors(threadedCursors.data(), cursorCount, step, true, threadedFrames.data(), &workers);
+        auto t5 = std::chrono::high_resolution_clock::now();
+
+        lookupTime += std::chrono::duration<double, std::nano>(t1 - t0).count();
+        cursorTime += std::chrono::duration<double, std::nano>(t2 - t1).count();
+        lookupDistanceTime += std::chrono::duration<double, std::nano>(t3 - t2).count();
+        cursorDistanceTime += std::chrono::duration<double, std::nano>(t4 - t3).count();
+        threadedTime += std::chrono::duration<double, std::nano>(t5 - t4).count();
+        for (size_t i = 0; i < cursorCount; i += 97)
+            maxDifference = std::max(maxDifference, std::hypot(lookupFrames[i].position.x - cursorFrames[i].position.x, lookupFrames[i].position.y - cursorFrames[i].position.y));
+        for (size_t i = 0; i < cursorCount; ++i)
+            threadedSame = threadedSame && threadedFrames[i].position.x == cursorFrames[i].position.x && threadedFrames[i].position.y == cursorFrames[i].position.y;
+    }
+
+    double perCursor = 1.0 / (cursorCount * frames);
+    cout << endl << "Spline cursors (" << cursorCount << " cursors x " << frames << " frames, position + tangent + curvature, ns per cursor)" << endl;
+    cout << "  by time:     lookup " << lookupTime * perCursor << ", cursor " << cursorTime * perCursor << endl;
+    cout << "  by distance: lookup " << lookupDistanceTime * perCursor << ", cursor " << cursorDistanceTime * perCursor
+         << ", cursor on " << workers.getThreadCount() << " threads " << threadedTime * perCursor << (threadedSame ? "" : " (DIFFERENT frames)")
+         << " (max position difference " << maxDifference << ")" << endl;
+}
+
+// Non-uniform Catmull-Rom straight from the definition (Barry-Goldman pyramid of lerps between the knots), what a
+// centripetal / chordal evaluation costs when nothing is precomputed
+template <std::size_t Dimension, typename Scalar>
+SplineVector<Dimension, Scalar> barryGoldman(const SplineVector<Dimension, Scalar>* P, Scalar alpha, Scalar u) {
+    Scalar t[4] = { 0, 0, 0, 0 };
+    for (int i = 1; i < 4; ++i) {
+        Scalar lengthSquared = 0;
+        for (std::size_t k = 0; k < Dimension; ++k) lengthSquared += (P[i][k] - P[i - 1][k]) * (P[i][k] - P[i - 1][k]);
+        Scalar knot = std::pow(lengthSquared, Scalar(0.5) * alpha);
+        t[i] = t[i - 1] + (knot > 0 ? knot : Scalar(1));
+    }
+    Scalar time = t[1] + u * (t[2] - t[1]);
+    auto lerp = [&](const SplineVector<Dimension, Scalar>& a, const SplineVector<Dimension, Scalar>& b, Scalar ta, Scalar tb) {
+        SplineVector<Dimension, Scalar> result;
+        for (std::size_t k = 0; k < Dimension; ++k) result[k] = ((tb - time) * a[k] + (time - ta) * b[k]) / (tb - ta);
+        return result;
+    };
+    SplineVector<Dimension, Scalar> A1 = lerp(P[0], P[1], t[0], t[1]), A2 = lerp(P[1], P[2], t[1], t[2]), A3 = lerp(P[2], P[3], t[2], t[3]);
+    SplineVector<Dimension, Scalar> B1 = lerp(A1, A2, t[0], t[2]), B2 = lerp(A2, A3, t[1], t[3]);
+    return lerp(B1, B2, t[1], t[2]);
+}
+
+// Number of places a polyline crosses itself (non neighbouring pieces only)
+size_t countSelfIntersections(const vector<Point>& line) {
+    auto cross = [](const Point& o, const Point& a, const Point& b) { return (a.x - o.x) * (b.y - o.y) - (a.y - o.y) * (b.x - o.x); };
+    size_t crossings = 0;
+    for (size_t i = 0; i + 1 < line.size(); ++i)
+        for (size_t j = i + 2; j + 1 < line.size(); ++j) {
+            const Point &a = line[i], &b = line[i + 1], &c = line[j], &d = line[j + 1];
+            if (cross(a, b, c) * cross(a, b, d) < 0 && cross(c, d, a) * cross(c, d, b) < 0) ++crossings;
+        }
+    return crossings;
+}
+
+// Uniform / centripetal / chordal: loops on unevenly spaced points, and the cost per evaluation of a 3D float camera rail
+void runParameterizationBenchmarks() {
+    cout << endl << "Catmull-Rom parameterization" << endl;
+
+    // a level designer's points: two close together just before a sharp turn
+    vector<Point> uneven = { { 0, 0 }, { 10, 0 }, { 10.4, 0.3 }, { 10.5, 6 }, { 4, 8 }, { 3.8, 8.2 }, { 12, 12 } };
+    vector<Point> line(SplineTessellation::pathPointCount(SplinePath(uneven), 64));
+    for (double alpha : { 0.0, 0.5, 1.0 }) {
+        SplinePath path(uneven, SplineEnds::Phantom, SplineSpacing::Uniform, alpha);
+        tessellatePath(path, 64, line.data());
+        cout << "  alpha " << alpha << ": " << countSelfIntersections(line) << " self intersections" << endl;
+    }
+
+    typedef CatmullRomSpline<3, float> CameraRail;
+    const size_t queryCount = 2000000;
+    std::mt19937 random(17);
+    std::uniform_real_distribution<float> coordinate(-50.0f, 50.0f), time(0.0f, 1.0f);
+    vector<CameraRail::Vector> points(512);
+    for (CameraRail::Vector& p : points) p = { { coordinate(random), coordinate(random), coordinate(random) * 0.1f } };
+    vector<float> times(queryCount);
+    for (float& t : times) t = time(random);
+
+    for (float alpha : { 0.0f, 0.5f, 1.0f }) {
+        CameraRail rail(points, alpha);
+        float checksum = 0, maxDifference = 0;
+        auto t0 = std::chrono::high_resolution_clock::now();
+        for (float t : times) checksum += rail.getPoint(t)[0];
+        auto t1 = std::chrono::high_resolution_clock::now();
+        for (float t : times) {
+            // the four points around the segment, with the same phantom ends
+            float u;
+            std::ptrdiff_t segment = static_cast<std::ptrdiff_t>(rail.findSegment(t, u)), last = static_cast<std::ptrdiff_t>(points.size()) - 1;
+            CameraRail::Vector P[4];
+            for (std::ptrdiff_t i = 0; i < 4; ++i) {
+                std::ptrdiff_t index = segment - 1 + i;
+                if (index < 0 || index > last) {
+                    std::ptrdiff_t end = index < 0 ? 0 : last, neighbour = index < 0 ? 1 : last - 1;
+                    for (int k = 0; k < 3; ++k) P[i][k] = 2 * points[end][k] - points[neighbour][k];
+                }
+                else P[i] = points[index];
+            }
+            checksum -= barryGoldman<3, float>(P, alpha, u)[0];
+        }
+        auto t2 = std::chrono::high_resolution_clock::now();
+
+        for (size_t i = 0; i < 1000; ++i) {
+            float t = static_cast<float>(i) / 1000, u;
+            std::ptrdiff_t segment = static_cast<std::ptrdiff_t>(rail.findSegment(t, u));
+            if (segment == 0 || segment + 2 >= static_cast<std::ptrdiff_t>(points.size())) continue;
+            CameraRail::Vector expected = barryGoldman<3, float>(&points[segment - 1], alpha, u), actual = rail.getPoint(t);
+            for (int k = 0; k < 3; ++k) maxDifference = std::max(maxDifference, std::abs(expected[k] - actual[k]));
+        }
+
+        auto ns = [&](std::chrono::high_resolution_clock::time_point a, std::chrono::high_resolution_clock::time_point b) {
+            return std::chrono::duration<double, std::nano>(b - a).count() / queryCount;
+        };
+        cout << "  3D float rail, alpha " << alpha << ": precomputed " << ns(t0, t1) << " ns, Barry-Goldman per query " << ns(t1, t2)
+             << " ns (max difference " << maxDifference << ", checksum " << checksum << ")" << endl;
+    }
+}
+
+// Nearest point on a long path for many positions: every segment checked against the segment hierarchy
+void runClosestPointBenchmarks() {
+    const size_t queryCount = 100000;
+    const size_t bruteForceCount = 500;
+
+    // a patrol route that winds back over itself
+    vector<Point> points(10001);
+    for (size_t i = 0; i < points.size(); ++i) {
+        double angle = 0.01 * i;
+        points[i] = { 300 * std::cos(angle * 0.37) + 40 * std::sin(angle * 3), 200 * std::sin(angle * 0.53) + 40 * std::cos(angle * 2.1) };
+    }
+    SplinePath path(points);
+
+    auto start = std::chrono::high_resolution_clock::now();
+    SplinePathBVH tree(path);
+    auto end = std::chrono::high_resolution_clock::now();
+
+    std::mt19937 random(19);
+    std::uniform_real_distribution<double> coordinate(-400.0, 400.0);
+    vector<Point> queries(queryCount);
+    for (Point& q : queries) q = { coordinate(random), coordinate(random) };
+    vector<SplineClosestPoint> results(queryCount);
+
+    auto t0 = std::chrono::high_resolution_clock::now();
+    tree.closestPoints(queries.data(), results.data(), queryCount);
+    auto t1 = std::chrono::high_resolution_clock::now();
+
+    // every segment with the same per segment search
+    double bruteChecksum = 0, maxDifference = 0;
+    auto t2 = std::chrono::high_resolution_clock::now();
+    for (size_t i = 0; i < bruteForceCount; ++i) {
+        double best = std::numeric_limits<double>::infinity(), u;
+        for (size_t segment = 0; segment < path.getSegmentCount(); ++segment)
+            best = std::min(best, SplinePathBVH::closestOnSegment(path.getSegment(segment), queries[i], u));
+        bruteChecksum += std::sqrt(best);
+        maxDifference = std::max(maxDifference, std::abs(std::sqrt(best) - results[i].distance));
+    }
+    auto t3 = std::chrono::high_resolution_clock::now();
+
+    // against dense sampling, which does not depend on the seeding or Newton steps
+    double maxDenseDifference = 0;
+    for (size_t i = 0; i < 50; ++i) {
+        double best = std::numeric_limits<double>::infinity();
+        for (size_t segment = 0; segment < path.getSegmentCount(); ++segment)
+            for (int k = 0; k <= 256; ++k) {
+                Point q = path.getSegmentPoint(segment, k / 256.0);
+                best = std::min(best, std::hypot(q.x - queries[i].x, q.y - queries[i].y));
+            }
+        maxDenseDifference = std::max(maxDenseDifference, results[i].distance - best);
+    }
+
+    cout << endl << "Closest point on a " << path.getSegmentCount() << " segment path (tree " << tree.getNodeCount() << " nodes, "
+         << tree.memoryUsage() / 1024 << " KB, built in " << std::chrono::duration<double, std::milli>(end - start).count() << " ms)" << endl;
+    cout << "  hierarchy " << std::chrono::duration<double, std::micro>(t1 - t0).count() / queryCount << " us per query, every segment "
+         << std::chrono::duration<double, std::micro>(t3 - t2).count() / bruteForceCount << " us per query" << endl;
+    cout << "  max difference to every segment " << maxDifference << ", to dense sampling " << maxDenseDifference << " (checksum " << bruteChecksum << ")" << endl;
+}
+
+// What plotCurve did before CurveRasterizer: a grid of rows, only the sample points marked, one output per character
+void plotCurveGrid(const vector<Point>& curve, std::ostream& out) {
+    const int width = 80;
+    const int height = 80;
     double minX = curve[0].x, maxX = curve[0].x;
     double minY = curve[0].y, maxY = curve[0].y;
     for (const auto& p : curve) {
-        if (p.x < minX) minX = p.x;
-        if (p.x > maxX) maxX = p.x;
-        if (p.y < minY) minY = p.y;
-        if (p.y > maxY) maxY = p.y;
+        minX = std::min(minX, p.x); maxX = std::max(maxX, p.x);
+        minY = std::min(minY, p.y); maxY = std::max(maxY, p.y);
     }
-
-    // Create an empty grid
     vector<vector<char>> grid(height, vector<char>(width, ' '));
-
-    // Map curve points to the grid
     for (const auto& p : curve) {
         int x = static_cast<int>((p.x - minX) / (maxX - minX) * (width - 1));
-        int y = static_cast<int>((p.y - minY) / (maxY - minY) * (height - 1));
-        y = height - 1 - y; // Flip Y-axis for correct orientation
+        int y = height - 1 - static_cast<int>((p.y - minY) / (maxY - minY) * (height - 1));
         grid[y][x] = '*';
     }
-
-    // Print the grid
     for (const auto& row : grid) {
-        for (char c : row) {
-            cout << c;
-        }
-        cout << endl;
+        for (char c : row) out << c;
+        out << endl;
     }
 }
 
+// Many curves drawn for image comparisons, the 80x80 ASCII plot against the old grid, and a sample image on disk
+void runRasterizerBenchmarks() {
+    const size_t curveCount = 2000;
+    const int numSamples = 64;
+
+    std::mt19937 random(23);
+    std::uniform_real_distribution<double> coordinate(-10.0, 10.0);
+    vector<vector<Point>> curves(curveCount, vector<Point>(numSamples + 1));
+    for (vector<Point>& curve : curves) {
+        Point P[4];
+        for (Point& p : P) p = { coordinate(random), coordinate(random) };
+        tessellateCurve(P[0], P[1], P[2], P[3], numSamples, curve.data());
+    }
+
+    // one 256x256 image per curve, the way a regression check renders them
+    CurveRasterizer image(256, 256);
+    size_t litPixels = 0;
+    auto t0 = std::chrono::high_resolution_clock::now();
+    for (const vector<Point>& curve : curves) {
+        image.clear();
+        image.fitView({ &curve });
+        image.drawCurve(curve);
+        litPixels += image.data()[128 * 256 * 3 + 128 * 3] > 0;
+    }
+    auto t1 = std::chrono::high_resolution_clock::now();
+
+    // ASCII output of the same curves, into a string stream so the terminal speed does not count
+    std::ostringstream gridOutput, asciiOutput;
+    auto t2 = std::chrono::high_resolution_clock::now();
+    for (size_t i = 0; i < 200; ++i) plotCurveGrid(curves[i], gridOutput);
+    auto t3 = std::chrono::high_resolution_clock::now();
+    CurveRasterizer ascii(80, 80);
+    for (size_t i = 0; i < 200; ++i) {
+        ascii.clear();
+        ascii.fitView({ &curves[i] });
+        ascii.drawCurve(curves[i]);
+        asciiOutput << ascii.toAscii();
+    }
+    auto t4 = std::chrono::high_resolution_clock::now();
+
+    cout << endl << "Rasterizer" << endl;
+    cout << "  " << curveCount << " curves, one 256x256 anti-aliased image each: "
+         << curveCount / std::chrono::duration<double>(t1 - t0).count() << " curves per second (" << litPixels << " centre pixels lit)" << endl;
+    cout << "  80x80 ASCII plot: old grid " << std::chrono::duration<double, std::micro>(t3 - t2).count() / 200 << " us, rasterizer "
+         << std::chrono::duration<double, std::micro>(t4 - t3).count() / 200 << " us per plot" << endl;
+
+    // uniform, centripetal and chordal through the same points in one image, and a vertical line (zero width range)
+    vector<Point> uneven = { { 0, 0 }, { 10, 0 }, { 10.4, 0.3 }, { 10.5, 6 }, { 4, 8 }, { 3.8, 8.2 }, { 12, 12 } };
+    vector<Point> lines[3];
+    const CurveColor colors[3] = { { 255, 80, 80 }, { 80, 255, 80 }, { 80, 120, 255 } };
+    for (int i = 0; i < 3; ++i) {
+        SplinePath path(uneven, SplineEnds::Phantom, SplineSpacing::Uniform, i * 0.5);
+        lines[i].resize(SplineTessellation::pathPointCount(path, 64));
+        tessellatePath(path, 64, lines[i].data());
+    }
+    CurveRasterizer picture(512, 512);
+    picture.fitView({ &lines[0], &lines[1], &lines[2] });
+    for (int i = 0; i < 3; ++i) picture.drawCurve(lines[i], colors[i]);
+    std::string path = (std::filesystem::temp_directory_path() / "catmull_rom_parameterizations.ppm").string();
+    cout << "  uniform / centripetal / chordal image " << (picture.writePPM(path) ? "written to " + path : "could not be written") << endl;
+
+    CurveRasterizer vertical(8, 4);
+    vector<Point> straightUp = { { 2, 0 }, { 2, 5 } };
+    vertical.fitView({ &straightUp });
+    vertical.drawCurve(straightUp);
+    cout << "  vertical line (maxX == minX):" << endl << vertical.toAscii();
+}
+
 int main()
 {
     // Define four control points.
@@ -122,6 +676,26 @@ int main()
     Point pointAtTime = getPointOnCurve(P0, P1, P2, P3, time);
 
     cout << "At time " << time << " the following point was observed on the curve : " << "(" << pointAtTime.x << ", " << pointAtTime.y << ")\n";
-    
+
+    // Any number of points: a path through all of them
+    vector<Point> points = { { 0, 1 }, { 2, 3 }, { 3, 3 }, { 4, 1 }, { 6, 0 }, { 7, 2 } };
+    SplinePath path(points);
+
+    vector<Point> pathCurve;
+    for (int i = 0; i <= 200; ++i) pathCurve.push_back(path.getPoint(i / 200.0));
+    plotCurve(pathCurve);
+
+    Point pointOnPath = path.getPoint(time);
+    cout << "At time " << time << " the path through " << points.size() << " points is at (" << pointOnPath.x << ", " << pointOnPath.y << ")\n";
+
+    runSplinePathBenchmarks();
+    runArcLengthBenchmarks();
+    runTessellationBenchmarks();
+    runAdaptiveTessellationBenchmarks();
+    runCursorBenchmarks();
+    runParameterizationBenchmarks();
+    runClosestPointBenchmarks();
+    runRasterizerBenchmarks();
+    return 0;
 }
 
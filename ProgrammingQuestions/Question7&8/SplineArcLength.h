@@ -0,0 +1,153 @@
+// Arc length table for a SplinePath, for moving along the path at a constant speed
+//
+// The time u of a Catmull-Rom segment is not proportional to the distance travelled, so stepping t by a fixed amount
+// every frame speeds up and slows down with the spacing and the bends of the path. The table splits every segment
+// into samplesPerSegment equal steps of u and stores the distance from the start of the path to the start of every
+// step, each step's length integrated with 5 point Gauss-Legendre quadrature of |dP/du|.
+//
+// distance -> (segment, u) is then a binary search for the step, a linear guess inside it and one Newton step on the
+// arc length (the length of the guess from the step start, again by quadrature, divided by the speed there).
+// On smooth paths the position is within about 1e-5 of the path length of where it should be with the default 8 steps
+// per segment. Near a cusp (a bend so sharp the speed almost drops to 0) the single Newton step is much less accurate,
+// more samplesPerSegment brings it back down (the error falls with roughly the 4th power of the step).
+// The table keeps a pointer to its path, so the path has to outlive it.
+
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+
+#include "SplinePath.h"
+
+class SplineArcLengthTable {
+private:
+    const SplinePath* path;
+    std::size_t samplesPerSegment;
+    double step;                          // 1 / samplesPerSegment, the u covered by one table entry
+    std::vector<double> distances;        // distances[j] is the length of the path up to segment j / n at u = (j % n) / n
+
+    static double speed(const SplinePath::Segment& segment, double u) {
+        Point velocity = segment.derivative(u);
+        return std::sqrt(velocity.x * velocity.x + velocity.y * velocity.y);
+    }
+
+    // length of the segment between u0 and u1
+    static double integrate(const SplinePath::Segment& segment, double u0, double u1) {
+        // 5 point Gauss-Legendre nodes and weights on [-1, 1]
+        static const double nodes[5] = { 0.0, -0.5384693101056831, 0.5384693101056831, -0.9061798459386640, 0.9061798459386640 };
+        static const double weights[5] = { 0.5688888888888889, 0.4786286704993665, 0.4786286704993665, 0.2369268850561891, 0.2369268850561891 };
+
+        double half = 0.5 * (u1 - u0), middle = 0.5 * (u0 + u1);
+        double length = 0;
+        for (int i = 0; i < 5; ++i)
+            length += weights[i] * speed(segment, middle + half * nodes[i]);
+        return length * half;
+    }
+
+    // segment and u of a distance (already clamped) inside the step starting at table entry
+    std::size_t refine(std::size_t entry, double distance, double& u) const {
+        std::size_t segmentIndex = entry / samplesPerSegment;
+        const SplinePath::Segment& segment = path->getSegment(segmentIndex);
+
+        // linear guess inside the step, then one Newton step on length(u0, u) - wanted
+        double u0 = (entry % samplesPerSegment) * step;
+        double stepLength = distances[entry + 1] - distances[entry];
+        double wanted = distance - distances[entry];
+        u = stepLength > 0 ? u0 + step * wanted / stepLength : u0;
+        double velocity = speed(segment, u);
+        if (velocity > 0)
+            u -= (integrate(segment, u0, u) - wanted) / velocity;
+        u = std::min(std::max(u, u0), u0 + step);
+        return segmentIndex;
+    }
+
+public:
+    explicit SplineArcLengthTable(const SplinePath& path, std::size_t samplesPerSegment = 8)
+        : path(&path), samplesPerSegment(std::max<std::size_t>(1, samplesPerSegment)) {
+        step = 1.0 / this->samplesPerSegment;
+        std::size_t entries = path.getSegmentCount() * this->samplesPerSegment;
+        distances.resize(entries + 1);
+        distances[0] = 0;
+        for (std::size_t j = 0; j < entries; ++j) {
+            double u = (j % this->samplesPerSegment) * step;
+            distances[j + 1] = distances[j] + integrate(path.getSegment(j / this->samplesPerSegment), u, u + step);
+        }
+    }
+
+    const SplinePath& getPath() const { return *path; }
+    double getLength() const { return distances.back(); }
+    std::size_t memoryUsage() const { return distances.size() * sizeof(double); }
+
+    // Segment and time u inside it at the given distance along the path (clamped to [0, getLength()])
+    std::size_t findDistance(double distance, double& u) const {
+        distance = std::min(std::max(distance, 0.0), distances.back());
+
+        // last entry <= distance among the entries that start a step, branch free like SplinePath::findSegment
+        const double* base = distances.data();
+        std::size_t length = distances.size() - 1;
+        while (length > 1) {
+            std::size_t half = length / 2;
+            base = base[half] <= distance ? base + half : base;
+            length -= half;
+        }
+        return refine(static_cast<std::size_t>(base - distances.data()), distance, u);
+    }
+
+    // Same as findDistance, but walks from the table entry of an earlier call instead of searching, for distances that
+    // only grow a little between calls (cursors, agents). entry is updated for the next call, start it at 0
+    std::size_t findDistanceFrom(std::size_t& entry, double distance, double& u) const {
+        distance = std::min(std::max(distance, 0.0), distances.back());
+        std::size_t last = distances.size() - 2;
+        entry = std::min(entry, last);
+        while (entry < last && distances[entry + 1] <= distance) ++entry;
+        while (entry > 0 && distances[entry] > distance) --entry;
+        return refine(entry, distance, u);
+    }
+
+    // Path time t (the input of SplinePath::getPoint) at the given distance along the path
+    double getTime(double distance) const {
+        double u;
+        std::size_t segment = findDistance(distance, u);
+        return path->getTime(segment, u);
+    }
+
+    // Point at the given distance in [0, getLength()] along the path
+    Point getPoint(double distance) const {
+        if (distance < 0.0 || distance > getLength()) {
+            throw std::out_of_range("Distance must be in the range [0, path length]");
+        }
+        double u;
+        std::size_t segment = findDistance(distance, u);
+        return path->getSegmentPoint(segment, u);
+    }
+
+    // Distance along the path at path time t in [0, 1], the inverse of getTime
+    double getDistance(double t) const {
+        double u;
+        std::size_t segment = path->findSegment(t, u);
+        return getDistance(segment, u);
+    }
+
+    // Distance along the path at time u of a segment
+    double getDistance(std::size_t segment, double u) const {
+        std::size_t entry = std::min(static_cast<std::size_t>(u * samplesPerSegment), samplesPerSegment - 1);
+        return distances[segment * samplesPerSegment + entry] + integrate(path->getSegment(segment), entry * step, u);
+    }
+
+    // first table entry of a segment time, the starting entry for findDistanceFrom
+    std::size_t getEntry(std::size_t segment, double u) const {
+        return segment * samplesPerSegment + std::min(static_cast<std::size_t>(u * samplesPerSegment), samplesPerSegment - 1);
+    }
+
+    // Points at count distances (clamped to the path), for many agents sharing one path
+    void getPoints(const double* distancesAlong, Point* points, std::size_t count) const {
+        for (std::size_t i = 0; i < count; ++i) {
+            double u;
+            std::size_t segment = findDistance(distancesAlong[i], u);
+            points[i] = path->getSegmentPoint(segment, u);
+        }
+    }
+};
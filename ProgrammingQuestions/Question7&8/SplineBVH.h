@@ -0,0 +1,203 @@
+// Bounding volume hierarchy over the segments of a SplinePath, for nearest point on path queries
+// (AI steering towards a path, snapping to a rail)
+//
+// A Catmull-Rom segment is not inside the hull of its own four points, but written as a Bezier curve
+// (B0 = P(0), B1 = P(0) + P'(0) / 3, B2 = P(1) - P'(1) / 3, B3 = P(1)) it is inside the hull of B0..B3, so the box
+// around those four points is a conservative box for the segment. The boxes are put into a binary tree (split at the
+// median centre along the longer axis, up to leafSize segments per leaf). A query walks the tree nearest child first and
+// skips every box that is further away than the best point found so far. Inside a segment the closest point is
+// seeded from a few samples and refined with Newton iterations on (P(u) - p) . P'(u) = 0.
+// The tree keeps a pointer to its path, so the path has to outlive it.
+
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+#include "SplinePath.h"
+
+struct SplineClosestPoint {
+    Point point;                // nearest point on the path
+    std::size_t segment = 0;    // segment it is on, and the time inside that segment
+    double u = 0;
+    double distance = 0;
+};
+
+class SplinePathBVH {
+private:
+    struct Box {
+        double minX, minY, maxX, maxY;
+
+        // squared distance from p to the box, 0 inside
+        double distanceSquared(const Point& p) const {
+            double dx = std::max(std::max(minX - p.x, p.x - maxX), 0.0);
+            double dy = std::max(std::max(minY - p.y, p.y - maxY), 0.0);
+            return dx * dx + dy * dy;
+        }
+
+        void grow(const Box& other) {
+            minX = std::min(minX, other.minX); minY = std::min(minY, other.minY);
+            maxX = std::max(maxX, other.maxX); maxY = std::max(maxY, other.maxY);
+        }
+    };
+
+    // an internal node's children are nodes[first] and nodes[first + 1], a leaf holds items[first, first + count)
+    struct Node {
+        Box box;
+        std::uint32_t first;
+        std::uint32_t count;          // 0 for an internal node
+    };
+
+    static constexpr std::size_t leafSize = 4;
+    static constexpr int newtonIterations = 4;
+    static constexpr int seedSamples = 8;
+
+    const SplinePath* path;
+    std::vector<Node> nodes;
+    std::vector<std::uint32_t> items;     // segment indices, in leaf order
+    std::vector<Box> itemBoxes;           // box of items[i], so a leaf can skip single segments
+
+    static Box segmentBox(const SplinePath::Segment& segment) {
+        Point B0 = segment.evaluate(0), B3 = segment.evaluate(1);
+        Point V0 = segment.derivative(0), V1 = segment.derivative(1);
+        Point B1 = { B0.x + V0.x / 3, B0.y + V0.y / 3 }, B2 = { B3.x - V1.x / 3, B3.y - V1.y / 3 };
+        return { std::min(std::min(B0.x, B1.x), std::min(B2.x, B3.x)), std::min(std::min(B0.y, B1.y), std::min(B2.y, B3.y)),
+                 std::max(std::max(B0.x, B1.x), std::max(B2.x, B3.x)), std::max(std::max(B0.y, B1.y), std::max(B2.y, B3.y)) };
+    }
+
+    // builds the node at index for items[begin, end)
+    void build(std::size_t index, std::size_t begin, std::size_t end, std::vector<Box>& boxes) {
+        Box box = boxes[items[begin]];
+        for (std::size_t i = begin + 1; i < end; ++i) box.grow(boxes[items[i]]);
+        nodes[index].box = box;
+
+        if (end - begin <= leafSize) {
+            nodes[index].first = static_cast<std::uint32_t>(begin);
+            nodes[index].count = static_cast<std::uint32_t>(end - begin);
+            return;
+        }
+
+        // median of the box centres along the longer axis
+        bool alongX = box.maxX - box.minX >= box.maxY - box.minY;
+        std::size_t middle = begin + (end - begin) / 2;
+        std::nth_element(items.begin() + begin, items.begin() + middle, items.begin() + end, [&](std::uint32_t a, std::uint32_t b) {
+            return alongX ? boxes[a].minX + boxes[a].maxX < boxes[b].minX + boxes[b].maxX
+                          : boxes[a].minY + boxes[a].maxY < boxes[b].minY + boxes[b].maxY;
+        });
+
+        std::size_t children = nodes.size();
+        nodes[index].first = static_cast<std::uint32_t>(children);
+        nodes[index].count = 0;
+        nodes.resize(children + 2);
+        build(children, begin, middle, boxes);
+        build(children + 1, middle, end, boxes);
+    }
+
+public:
+    // Closest point of one segment to p, returns the squared distance and sets u
+    static double closestOnSegment(const SplinePath::Segment& segment, const Point& p, double& u) {
+        // seed from the nearest of a few evenly spaced samples (ends included)
+        double bestSquared = std::numeric_limits<double>::infinity();
+        for (int i = 0; i <= seedSamples; ++i) {
+            double sampleU = static_cast<double>(i) / seedSamples;
+            Point q = segment.evaluate(sampleU);
+            double squared = (q.x - p.x) * (q.x - p.x) + (q.y - p.y) * (q.y - p.y);
+            if (squared < bestSquared) {
+                bestSquared = squared;
+                u = sampleU;
+            }
+        }
+
+        // Newton on f(u) = (P(u) - p) . P'(u), f'(u) = P'(u) . P'(u) + (P(u) - p) . P''(u), kept inside [0, 1]
+        double current = u;
+        for (int i = 0; i < newtonIterations; ++i) {
+            Point q = segment.evaluate(current), velocity = segment.derivative(current), acceleration = segment.secondDerivative(current);
+            double dx = q.x - p.x, dy = q.y - p.y;
+            double f = dx * velocity.x + dy * velocity.y;
+            double slope = velocity.x * velocity.x + velocity.y * velocity.y + dx * acceleration.x + dy * acceleration.y;
+            if (slope <= 0) break;
+            current = std::min(std::max(current - f / slope, 0.0), 1.0);
+        }
+        Point q = segment.evaluate(current);
+        double squared = (q.x - p.x) * (q.x - p.x) + (q.y - p.y) * (q.y - p.y);
+        if (squared < bestSquared) {
+            bestSquared = squared;
+            u = current;
+        }
+        return bestSquared;
+    }
+
+    explicit SplinePathBVH(const SplinePath& path) : path(&path) {
+        std::size_t count = path.getSegmentCount();
+        std::vector<Box> boxes(count);
+        items.resize(count);
+        for (std::size_t i = 0; i < count; ++i) {
+            boxes[i] = segmentBox(path.getSegment(i));
+            items[i] = static_cast<std::uint32_t>(i);
+        }
+
+        nodes.reserve(2 * (count / leafSize + 1));
+        nodes.resize(1);
+        build(0, 0, count, boxes);
+
+        itemBoxes.resize(count);
+        for (std::size_t i = 0; i < count; ++i) itemBoxes[i] = boxes[items[i]];
+    }
+
+    const SplinePath& getPath() const { return *path; }
+    std::size_t getNodeCount() const { return nodes.size(); }
+    std::size_t memoryUsage() const { return nodes.size() * sizeof(Node) + items.size() * (sizeof(std::uint32_t) + sizeof(Box)); }
+
+    // Nearest point on the path to p
+    SplineClosestPoint closestPoint(const Point& p) const {
+        SplineClosestPoint result;
+        double bestSquared = std::numeric_limits<double>::infinity();
+
+        // depth first, nearer child first. The median split keeps the tree log2(segments / leafSize) deep and the stack
+        // holds at most one entry per level plus one
+        std::uint32_t stack[64];
+        int top = 0;
+        stack[top++] = 0;
+        while (top > 0) {
+            const Node& node = nodes[stack[--top]];
+            if (node.box.distanceSquared(p) >= bestSquared) continue;
+
+            if (node.count > 0) {
+                for (std::uint32_t i = node.first; i < node.first + node.count; ++i) {
+                    if (itemBoxes[i].distanceSquared(p) >= bestSquared) continue;
+                    double u;
+                    double squared = closestOnSegment(path->getSegment(items[i]), p, u);
+                    if (squared < bestSquared) {
+                        bestSquared = squared;
+                        result.segment = items[i];
+                        result.u = u;
+                    }
+                }
+                continue;
+            }
+
+            double nearDistance = nodes[node.first].box.distanceSquared(p), farDistance = nodes[node.first + 1].box.distanceSquared(p);
+            std::uint32_t nearChild = node.first, farChild = node.first + 1;
+            if (farDistance < nearDistance) {
+                std::swap(nearChild, farChild);
+                std::swap(nearDistance, farDistance);
+            }
+            // the far child is pushed first so the near one is searched first
+            if (farDistance < bestSquared) stack[top++] = farChild;
+            if (nearDistance < bestSquared) stack[top++] = nearChild;
+        }
+
+        result.point = path->getSegmentPoint(result.segment, result.u);
+        result.distance = std::sqrt(bestSquared);
+        return result;
+    }
+
+    // closestPoint for count query points
+    void closestPoints(const Point* points, SplineClosestPoint* results, std::size_t count) const {
+        for (std::size_t i = 0; i < count; ++i) results[i] = closestPoint(points[i]);
+    }
+};
@@ -0,0 +1,192 @@
+// Cursor that follows a SplinePath frame by frame (enemies on their path, camera rails)
+//
+// Calling getPointOnCurve / SplinePath::getPoint every frame with a slightly larger t range checks, locates the
+// segment and loads its coefficients again every time. A SplineCursor keeps the segment it is in, a copy of that
+// segment's coefficients and the segment's share of the path time, so advancing is an add and a compare, and only
+// crossing into the next segment (at most a few times per frame) touches the path again.
+//   advance(dt)               - moves by path time, like stepping t
+//   advanceDistance(distance) - moves by distance along the path (constant speed), needs a SplineArcLengthTable and
+//                               walks its entries from where the cursor was instead of searching
+// evaluate() returns the position, unit tangent and signed curvature from one pass over the cubic.
+// Cursors are 128 bytes and cache line aligned, so a std::vector of them is one contiguous array and
+// advanceCursors can split it over the threads of a WorkerPool without two threads ever writing the same line.
+
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+
+#include "SplinePath.h"
+#include "SplineArcLength.h"
+#include "WorkerPool.h"
+
+// Where a cursor is: position, direction of travel (unit length) and curvature (1 / turning radius, positive when
+// turning left)
+struct SplineFrame {
+    Point position;
+    Point tangent;
+    double curvature;
+};
+
+class alignas(64) SplineCursor {
+private:
+    SplinePath::Segment coefficients;             // copy of the current segment
+    const SplinePath* path;
+    const SplineArcLengthTable* table;            // null when the cursor only moves by path time
+    std::size_t segment = 0;
+    std::size_t entry = 0;                        // table entry the distance was last found in
+    double u = 0;                                 // time inside the segment
+    double inverseSpan = 1;                       // segment u per unit of path time
+    double distance = 0;                          // only kept up to date when the cursor has a table
+    bool finished = false;
+
+    void enterSegment(std::size_t index) {
+        segment = index;
+        coefficients = path->getSegment(index);
+        const std::vector<double>& knots = path->getKnots();
+        double span = knots[index + 1] - knots[index];
+        inverseSpan = span > 0 ? 1 / span : 0;
+    }
+
+public:
+    // Cursor at path time t
+    explicit SplineCursor(const SplinePath& path, double t = 0) : path(&path), table(nullptr) {
+        setTime(t);
+    }
+
+    // Cursor at a distance along the path, that can move by distance
+    explicit SplineCursor(const SplineArcLengthTable& table, double distance = 0) : path(&table.getPath()), table(&table) {
+        setDistance(distance);
+    }
+
+    void setTime(double t) {
+        double segmentTime;
+        enterSegment(path->findSegment(t, segmentTime));
+        u = segmentTime;
+        finished = false;
+        if (table) {
+            entry = table->getEntry(segment, u);
+            distance = table->getDistance(segment, u);
+        }
+    }
+
+    void setDistance(double newDistance) {
+        if (!table) throw std::logic_error("Moving by distance needs a cursor created from a SplineArcLengthTable.");
+        distance = std::min(std::max(newDistance, 0.0), table->getLength());
+        double segmentTime;
+        enterSegment(table->findDistanceFrom(entry, distance, segmentTime));
+        u = segmentTime;
+        finished = false;
+    }
+
+    // Moves forward by dt >= 0 of path time. An open path stops at its end (isFinished), a closed one wraps around.
+    void advance(double dt) {
+        if (dt <= 0 || finished) return;
+
+        // path time left over after the current segment, carried into the following ones
+        // (a segment with no share of the path time is passed straight through)
+        double left = dt;
+        if (inverseSpan > 0) {
+            u += dt * inverseSpan;
+            left = (u - 1) / inverseSpan;
+        }
+        if (left > 0 || inverseSpan == 0) {
+            std::size_t last = path->getSegmentCount() - 1;
+            while (true) {
+                if (segment == last && path->getEnds() != SplineEnds::Closed) {
+                    u = 1;
+                    finished = true;
+                    break;
+                }
+                enterSegment(segment == last ? 0 : segment + 1);
+                if (inverseSpan == 0) continue;
+                u = left * inverseSpan;
+                if (u <= 1) break;
+                left = (u - 1) / inverseSpan;
+            }
+        }
+        if (table) {
+            entry = table->getEntry(segment, u);
+            distance = table->getDistance(segment, u);
+        }
+    }
+
+    // Moves by distance along the path, which is constant speed for a constant distance per frame
+    void advanceDistance(double step) {
+        if (!table) throw std::logic_error("Moving by distance needs a cursor created from a SplineArcLengthTable.");
+        double newDistance = distance + step;
+        double length = table->getLength();
+        if (newDistance >= length) {
+            if (path->getEnds() == SplineEnds::Closed && length > 0) {
+                newDistance = std::fmod(newDistance, length);
+                entry = 0;
+            }
+            else {
+                newDistance = length;
+                finished = true;
+            }
+        }
+        distance = newDistance;
+
+        double segmentTime;
+        std::size_t index = table->findDistanceFrom(entry, distance, segmentTime);
+        if (index != segment) enterSegment(index);
+        u = segmentTime;
+    }
+
+    Point getPosition() const { return coefficients.evaluate(u); }
+
+    // Position, tangent and curvature, the cubic and both derivatives in one Horner pass
+    SplineFrame evaluate() const {
+        const Point* c = coefficients.c;
+        double px = c[3].x, py = c[3].y;                  // P
+        double vx = 0, vy = 0;                            // P'
+        double ax = 0, ay = 0;                            // P'' / 2
+        for (int i = 2; i >= 0; --i) {
+            ax = ax * u + vx;  ay = ay * u + vy;
+            vx = vx * u + px;  vy = vy * u + py;
+            px = px * u + c[i].x;  py = py * u + c[i].y;
+        }
+        ax *= 2; ay *= 2;
+
+        SplineFrame frame;
+        frame.position = { px, py };
+        double speed = std::sqrt(vx * vx + vy * vy);
+        if (speed > 0) {
+            frame.tangent = { vx / speed, vy / speed };
+            frame.curvature = (vx * ay - vy * ax) / (speed * speed * speed);
+        }
+        else {
+            frame.tangent = { 0, 0 };
+            frame.curvature = 0;
+        }
+        return frame;
+    }
+
+    const SplinePath& getPath() const { return *path; }
+    std::size_t getSegment() const { return segment; }
+    double getSegmentTime() const { return u; }
+    double getTime() const { return path->getTime(segment, u); }
+    double getDistance() const { return distance; }
+    bool isFinished() const { return finished; }
+};
+
+// Advances every cursor by dt of path time (or by dt of distance when byDistance is set) and, if frames is not null,
+// writes where each one ends up. With workers the array is split into one contiguous block per thread of the pool
+// (its threads stay up between frames), without them everything runs on the calling thread
+inline void advanceCursors(SplineCursor* cursors, std::size_t count, double dt, bool byDistance, SplineFrame* frames, WorkerPool* workers = nullptr) {
+    auto work = [=](std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; ++i) {
+            if (byDistance) cursors[i].advanceDistance(dt);
+            else cursors[i].advance(dt);
+            if (frames) frames[i] = cursors[i].evaluate();
+        }
+    };
+
+    // below a few thousand cursors per thread waking the workers costs more than it saves
+    if (workers) workers->parallelFor(count, 2048, work);
+    else work(0, count);
+}
@@ -0,0 +1,185 @@
+// Catmull-Rom path through any number of points, the multi point version of catmullRom from Question7&8.cpp
+//
+// Segment i runs from point i to point i + 1 and uses points i - 1 and i + 2 for its tangents. The first and last
+// segment are missing one of those neighbours, SplineEnds decides what stands in for it:
+//   Phantom   - the end point mirrored through its neighbour (2 * P0 - P1), the path leaves the end heading along the chord
+//   Duplicate - the end point itself, the path leaves the end more slowly
+//   Closed    - the path loops back to the first point, the neighbours wrap around
+//
+// The path time t in [0, 1] is split over the segments by a table of cumulative parameters (knots): SplineSpacing::Uniform
+// gives every segment the same share of t, ChordLength gives each segment a share proportional to its length so
+// the speed is much more even along paths with uneven point spacing. With uniform spacing the segment is simply
+// t * segmentCount, otherwise getPoint binary searches the knots for it. Every segment keeps its cubic as precomputed
+// coefficients, so the evaluation itself is three multiply-adds per component.
+
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+
+#include "CatmullRomSpline.h"
+
+// Represents a 2D point in space.
+struct Point {
+    double x, y;
+};
+
+enum class SplineSpacing { Uniform, ChordLength };
+
+class SplinePath {
+public:
+    // P(u) = c[0] + c[1] * u + c[2] * u^2 + c[3] * u^3 for u in [0, 1]
+    struct Segment {
+        Point c[4];
+
+        Point evaluate(double u) const {
+            return { c[0].x + u * (c[1].x + u * (c[2].x + u * c[3].x)),
+                     c[0].y + u * (c[1].y + u * (c[2].y + u * c[3].y)) };
+        }
+
+        // dP/du, the velocity along the segment
+        Point derivative(double u) const {
+            return { c[1].x + u * (2 * c[2].x + u * 3 * c[3].x),
+                     c[1].y + u * (2 * c[2].y + u * 3 * c[3].y) };
+        }
+
+        // d2P/du2
+        Point secondDerivative(double u) const {
+            return { 2 * c[2].x + 6 * c[3].x * u, 2 * c[2].y + 6 * c[3].y * u };
+        }
+    };
+
+private:
+    std::vector<Point> points;
+    std::vector<Segment> segments;
+    std::vector<double> knots;            // knots[i] is the path time segment i starts at, knots.back() == 1
+    std::vector<double> inverseSpans;     // 1 / (knots[i + 1] - knots[i])
+    SplineEnds ends;
+    double alpha;
+    bool uniform;                         // every segment has the same share of t, the segment is found without the knots
+
+    // control point i, with the neighbours of the end points filled in as set by ends
+    Point controlPoint(std::ptrdiff_t i) const {
+        std::ptrdiff_t count = static_cast<std::ptrdiff_t>(points.size());
+        if (ends == SplineEnds::Closed) return points[(i % count + count) % count];
+        if (i < 0) return ends == SplineEnds::Phantom ? Point{ 2 * points[0].x - points[1].x, 2 * points[0].y - points[1].y } : points[0];
+        if (i >= count) {
+            const Point& last = points[count - 1];
+            const Point& previous = points[count - 2];
+            return ends == SplineEnds::Phantom ? Point{ 2 * last.x - previous.x, 2 * last.y - previous.y } : last;
+        }
+        return points[i];
+    }
+
+public:
+    // The same polynomial as catmullRom, grouped by powers of t. A non zero alpha gives the centripetal (0.5) or
+    // chordal (1) curve through the same points instead, see CatmullRomSpline.h
+    static Segment makeSegment(const Point& P0, const Point& P1, const Point& P2, const Point& P3, double alpha = 0) {
+        if (alpha != 0) {
+            CatmullRomSegment<2, double> generic = makeCatmullRomSegment<2, double>({ { P0.x, P0.y } }, { { P1.x, P1.y } }, { { P2.x, P2.y } }, { { P3.x, P3.y } }, alpha);
+            Segment segment;
+            for (int i = 0; i < 4; ++i) segment.c[i] = { generic.c[i][0], generic.c[i][1] };
+            return segment;
+        }
+        Segment segment;
+        segment.c[0] = P1;
+        segment.c[1] = { 0.5 * (-P0.x + P2.x), 0.5 * (-P0.y + P2.y) };
+        segment.c[2] = { 0.5 * (2 * P0.x - 5 * P1.x + 4 * P2.x - P3.x), 0.5 * (2 * P0.y - 5 * P1.y + 4 * P2.y - P3.y) };
+        segment.c[3] = { 0.5 * (-P0.x + 3 * P1.x - 3 * P2.x + P3.x), 0.5 * (-P0.y + 3 * P1.y - 3 * P2.y + P3.y) };
+        return segment;
+    }
+
+    // Needs at least 2 points (3 for a closed path). alpha 0 is the uniform catmullRom curve, 0.5 centripetal, 1 chordal
+    explicit SplinePath(const std::vector<Point>& points, SplineEnds ends = SplineEnds::Phantom, SplineSpacing spacing = SplineSpacing::Uniform, double alpha = 0)
+        : points(points), ends(ends), alpha(alpha), uniform(spacing == SplineSpacing::Uniform) {
+        if (points.size() < (ends == SplineEnds::Closed ? 3u : 2u))
+            throw std::invalid_argument("A spline path needs at least 2 points (3 if it is closed).");
+
+        std::size_t segmentCount = ends == SplineEnds::Closed ? points.size() : points.size() - 1;
+        segments.reserve(segmentCount);
+        for (std::size_t i = 0; i < segmentCount; ++i) {
+            std::ptrdiff_t p = static_cast<std::ptrdiff_t>(i);
+            segments.push_back(makeSegment(controlPoint(p - 1), controlPoint(p), controlPoint(p + 1), controlPoint(p + 2), alpha));
+        }
+
+        // cumulative share of t per segment, normalized so the last knot is exactly 1
+        knots.resize(segmentCount + 1);
+        knots[0] = 0;
+        for (std::size_t i = 0; i < segmentCount; ++i) {
+            double share = 1;
+            if (spacing == SplineSpacing::ChordLength) {
+                Point a = controlPoint(static_cast<std::ptrdiff_t>(i)), b = controlPoint(static_cast<std::ptrdiff_t>(i) + 1);
+                share = std::sqrt((b.x - a.x) * (b.x - a.x) + (b.y - a.y) * (b.y - a.y));
+            }
+            knots[i + 1] = knots[i] + share;
+        }
+        // all points on top of each other, fall back to uniform
+        if (knots.back() == 0) {
+            uniform = true;
+            for (std::size_t i = 0; i <= segmentCount; ++i) knots[i] = static_cast<double>(i);
+        }
+
+        double total = knots.back();
+        for (double& knot : knots) knot /= total;
+        knots.back() = 1;
+
+        inverseSpans.resize(segmentCount);
+        for (std::size_t i = 0; i < segmentCount; ++i)
+            inverseSpans[i] = knots[i + 1] > knots[i] ? 1 / (knots[i + 1] - knots[i]) : 0;
+    }
+
+    std::size_t getPointCount() const { return points.size(); }
+    std::size_t getSegmentCount() const { return segments.size(); }
+    const std::vector<Point>& getPoints() const { return points; }
+    const Segment& getSegment(std::size_t segment) const { return segments[segment]; }
+    const std::vector<double>& getKnots() const { return knots; }
+    SplineEnds getEnds() const { return ends; }
+    double getAlpha() const { return alpha; }
+
+    // Segment the path time t falls in, and the time u in [0, 1] inside that segment (t is clamped to [0, 1])
+    std::size_t findSegment(double t, double& u) const {
+        t = std::min(std::max(t, 0.0), 1.0);
+        std::size_t count = segments.size();
+        if (uniform) {
+            std::size_t segment = std::min(static_cast<std::size_t>(t * count), count - 1);
+            u = std::min(t * count - segment, 1.0);
+            return segment;
+        }
+
+        // last knot <= t among knots[0, count), halving the range with a conditional move instead of a branch, since
+        // random times make the branches of std::upper_bound mispredict about half of the time
+        const double* base = knots.data();
+        std::size_t length = count;
+        while (length > 1) {
+            std::size_t half = length / 2;
+            base = base[half] <= t ? base + half : base;
+            length -= half;
+        }
+        std::size_t segment = static_cast<std::size_t>(base - knots.data());
+        u = std::min((t - knots[segment]) * inverseSpans[segment], 1.0);
+        return segment;
+    }
+
+    // Point at path time t in [0, 1], passing through points[i] at t == knots[i]
+    Point getPoint(double t) const {
+        if (t < 0.0 || t > 1.0) {
+            throw std::out_of_range("Time parameter must be in the range [0,1]");
+        }
+        double u;
+        std::size_t segment = findSegment(t, u);
+        return segments[segment].evaluate(u);
+    }
+
+    // Path time t of time u in [0, 1] of a segment, the inverse of findSegment
+    double getTime(std::size_t segment, double u) const {
+        return knots[segment] + u * (knots[segment + 1] - knots[segment]);
+    }
+
+    // Point at time u in [0, 1] of one segment, unchecked
+    Point getSegmentPoint(std::size_t segment, double u) const {
+        return segments[segment].evaluate(u);
+    }
+};
@@ -0,0 +1,203 @@
+// Batch tessellation of Catmull-Rom segments into a caller provided buffer (trails, debug drawing)
+//
+// generateSmoothCurve evaluates the whole basis with t^2 and t^3 for every sample and push_backs into a new vector.
+// These functions take the precomputed cubic of a SplinePath::Segment and write numSamples + 1 evenly spaced points
+// (the same points as generateSmoothCurve) straight into out, which must have room for them. Nothing is allocated.
+//   forwardDifference - steps the cubic with three additions per component and point (the differences of a cubic
+//                       over a fixed step are a quadratic, a line and a constant), a serial chain of adds
+//   horner            - evaluates 4 samples at once with AVX (c0 + t * (c1 + t * (c2 + t * c3)) per lane) and
+//                       interleaves them into (x, y) pairs, one point at a time without AVX2
+// tessellateSegment uses horner when AVX2 is available (4 independent samples per step, on par with or faster than
+// forwardDifference) and forwardDifference otherwise (fewer operations per sample when they are done one at a time).
+//
+// adaptiveSegment / tessellatePathAdaptive place the points by curvature instead: an interval [u0, u1] of the cubic is
+// written as the Bezier curve B0..B3 (B0 = P(u0), B1 = B0 + P'(u0) * (u1 - u0) / 3, B2 = B3 - P'(u1) * (u1 - u0) / 3,
+// B3 = P(u1)) and halved until the curve is provably within tolerance of the chord B0 B3. The curve lies in the convex
+// hull of B0..B3, so it is never further from the chord than B1 and B2 are. When both project inside the chord the
+// whole curve does too, and its largest distance from the chord's line is found exactly from the Bezier form (a cubic
+// in t with a quadratic derivative). Straight stretches get one chord per segment and tight bends as many as they need.
+
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <algorithm>
+#include <stdexcept>
+
+#include "../MathLibrary/MathConfig.h"
+#include "SplinePath.h"
+
+namespace SplineTessellation {
+
+    // number of points tessellateSegment / tessellatePath write
+    inline std::size_t segmentPointCount(int numSamples) { return static_cast<std::size_t>(numSamples) + 1; }
+    inline std::size_t pathPointCount(const SplinePath& path, int samplesPerSegment) {
+        return path.getSegmentCount() * static_cast<std::size_t>(samplesPerSegment) + 1;
+    }
+
+    inline void forwardDifference(const SplinePath::Segment& segment, int numSamples, Point* out) {
+        double h = 1.0 / numSamples, h2 = h * h, h3 = h2 * h;
+        const Point* c = segment.c;
+
+        // P, and its first, second and third forward differences at t = 0
+        double x = c[0].x, dx = c[1].x * h + c[2].x * h2 + c[3].x * h3, ddx = 2 * c[2].x * h2 + 6 * c[3].x * h3, dddx = 6 * c[3].x * h3;
+        double y = c[0].y, dy = c[1].y * h + c[2].y * h2 + c[3].y * h3, ddy = 2 * c[2].y * h2 + 6 * c[3].y * h3, dddy = 6 * c[3].y * h3;
+        for (int i = 0; i < numSamples; ++i) {
+            out[i] = { x, y };
+            x += dx; dx += ddx; ddx += dddx;
+            y += dy; dy += ddy; ddy += dddy;
+        }
+        // the sums drift by a few ulps per step, so the end point is evaluated exactly and meets the next segment
+        out[numSamples] = segment.evaluate(1.0);
+    }
+
+    inline void horner(const SplinePath::Segment& segment, int numSamples, Point* out) {
+        double h = 1.0 / numSamples;
+        int i = 0;
+#ifdef MATH_USE_AVX2
+        const Point* c = segment.c;
+        __m256d cx0 = _mm256_set1_pd(c[0].x), cx1 = _mm256_set1_pd(c[1].x), cx2 = _mm256_set1_pd(c[2].x), cx3 = _mm256_set1_pd(c[3].x);
+        __m256d cy0 = _mm256_set1_pd(c[0].y), cy1 = _mm256_set1_pd(c[1].y), cy2 = _mm256_set1_pd(c[2].y), cy3 = _mm256_set1_pd(c[3].y);
+        __m256d step = _mm256_set1_pd(h);
+        __m256d lanes = _mm256_setr_pd(0, 1, 2, 3);
+        for (; i + 4 <= numSamples; i += 4) {
+            // t = i * h per lane, like generateSmoothCurve's i / numSamples up to rounding
+            __m256d t = _mm256_mul_pd(_mm256_add_pd(_mm256_set1_pd(static_cast<double>(i)), lanes), step);
+            __m256d x = _mm256_add_pd(cx0, _mm256_mul_pd(t, _mm256_add_pd(cx1, _mm256_mul_pd(t, _mm256_add_pd(cx2, _mm256_mul_pd(t, cx3))))));
+            __m256d y = _mm256_add_pd(cy0, _mm256_mul_pd(t, _mm256_add_pd(cy1, _mm256_mul_pd(t, _mm256_add_pd(cy2, _mm256_mul_pd(t, cy3))))));
+
+            // (x0 x1 x2 x3), (y0 y1 y2 y3) -> (x0 y0 x1 y1), (x2 y2 x3 y3)
+            __m256d low = _mm256_unpacklo_pd(x, y);    // x0 y0 x2 y2
+            __m256d high = _mm256_unpackhi_pd(x, y);   // x1 y1 x3 y3
+            double* destination = &out[i].x;
+            _mm256_storeu_pd(destination, _mm256_permute2f128_pd(low, high, 0x20));
+            _mm256_storeu_pd(destination + 4, _mm256_permute2f128_pd(low, high, 0x31));
+        }
+#endif
+        for (; i < numSamples; ++i)
+            out[i] = segment.evaluate(i * h);
+        out[numSamples] = segment.evaluate(1.0);
+    }
+
+    // Upper bound of the distance between the Bezier curve B0..B3 and its chord B0 B3
+    inline double chordError(const Point& B0, const Point& B1, const Point& B2, const Point& B3) {
+        double cx = B3.x - B0.x, cy = B3.y - B0.y;
+        double lengthSquared = cx * cx + cy * cy;
+        const Point* inner[2] = { &B1, &B2 };
+        double signedDistances[2] = { 0, 0 }, segment = 0;
+        bool inside = lengthSquared > 0;
+        for (int i = 0; i < 2; ++i) {
+            double px = inner[i]->x - B0.x, py = inner[i]->y - B0.y;
+            double along = lengthSquared > 0 ? (px * cx + py * cy) / lengthSquared : 0;
+            inside = inside && along >= 0 && along <= 1;
+            double clamped = std::min(std::max(along, 0.0), 1.0);
+            double dx = px - clamped * cx, dy = py - clamped * cy;
+            segment = std::max(segment, std::sqrt(dx * dx + dy * dy));
+            if (lengthSquared > 0) signedDistances[i] = (px * cy - py * cx) / std::sqrt(lengthSquared);
+        }
+        if (!inside) return segment;
+
+        // the whole curve projects onto the chord, so its distance is the distance to the chord's line:
+        // f(t) = 3 t (1 - t)^2 d1 + 3 t^2 (1 - t) d2, largest where f'(t) / 3 = d1 + (2 d2 - 4 d1) t + 3 (d1 - d2) t^2 is 0
+        double d1 = signedDistances[0], d2 = signedDistances[1];
+        auto f = [&](double t) { return std::abs(3 * t * (1 - t) * ((1 - t) * d1 + t * d2)); };
+        double a = 3 * (d1 - d2), b = 2 * d2 - 4 * d1, c = d1;
+        double largest = 0;
+        if (std::abs(a) < 1e-12 * (std::abs(b) + std::abs(c))) {
+            if (b != 0) largest = f(std::min(std::max(-c / b, 0.0), 1.0));
+        }
+        else {
+            double discriminant = std::max(b * b - 4 * a * c, 0.0), root = std::sqrt(discriminant);
+            largest = std::max(f(std::min(std::max((-b - root) / (2 * a), 0.0), 1.0)), f(std::min(std::max((-b + root) / (2 * a), 0.0), 1.0)));
+        }
+        return largest;
+    }
+
+    // Writes the points after u0 up to and including u1 (the start is written by the caller), at most capacity of them
+    // from out[count] on, and counts every point including the ones that did not fit
+    inline void subdivide(const SplinePath::Segment& segment, double u0, const Point& P0, const Point& V0, double u1, const Point& P1, const Point& V1,
+                          double tolerance, int depth, Point* out, double* times, std::size_t capacity, std::size_t& count) {
+        double third = (u1 - u0) / 3;
+        Point B1 = { P0.x + V0.x * third, P0.y + V0.y * third };
+        Point B2 = { P1.x - V1.x * third, P1.y - V1.y * third };
+        if (depth > 0 && chordError(P0, B1, B2, P1) > tolerance) {
+            double um = 0.5 * (u0 + u1);
+            Point Pm = segment.evaluate(um), Vm = segment.derivative(um);
+            subdivide(segment, u0, P0, V0, um, Pm, Vm, tolerance, depth - 1, out, times, capacity, count);
+            subdivide(segment, um, Pm, Vm, u1, P1, V1, tolerance, depth - 1, out, times, capacity, count);
+            return;
+        }
+        if (count < capacity) {
+            out[count] = P1;
+            if (times) times[count] = u1;
+        }
+        ++count;
+    }
+
+    // deepest halving, 2^20 chords per segment, so a zero tolerance still terminates
+    constexpr int maxSubdivisionDepth = 20;
+
+    // Points of one segment from u = 0 to 1, every chord within tolerance of the curve. Writes at most capacity points
+    // (and their u to times if it is not null) and returns how many the whole segment needs, so a buffer that was too
+    // small can be grown and the call repeated
+    inline std::size_t adaptiveSegment(const SplinePath::Segment& segment, double tolerance, Point* out, std::size_t capacity, double* times = nullptr) {
+        if (!(tolerance > 0)) throw std::invalid_argument("tolerance must be positive.");
+        std::size_t count = 0;
+        if (capacity > 0) {
+            out[0] = segment.c[0];
+            if (times) times[0] = 0;
+        }
+        ++count;
+        subdivide(segment, 0, segment.c[0], segment.c[1], 1, segment.evaluate(1.0), segment.derivative(1.0), tolerance,
+                  maxSubdivisionDepth, out, times, capacity, count);
+        return count;
+    }
+
+    // numSamples + 1 points from t = 0 to t = 1
+    inline void tessellateSegment(const SplinePath::Segment& segment, int numSamples, Point* out) {
+        if (numSamples <= 0) throw std::invalid_argument("numSamples must be positive.");
+#ifdef MATH_USE_AVX2
+        horner(segment, numSamples, out);
+#else
+        forwardDifference(segment, numSamples, out);
+#endif
+    }
+}
+
+// Same points as generateSmoothCurve(P0, P1, P2, P3, numSamples), written to out (numSamples + 1 points)
+inline void tessellateCurve(const Point& P0, const Point& P1, const Point& P2, const Point& P3, int numSamples, Point* out) {
+    SplineTessellation::tessellateSegment(SplinePath::makeSegment(P0, P1, P2, P3), numSamples, out);
+}
+
+// The whole path with samplesPerSegment steps per segment, SplineTessellation::pathPointCount points written to out.
+// Each segment's end point is its successor's first point, so it is only written once.
+inline void tessellatePath(const SplinePath& path, int samplesPerSegment, Point* out) {
+    for (std::size_t segment = 0; segment < path.getSegmentCount(); ++segment)
+        SplineTessellation::tessellateSegment(path.getSegment(segment), samplesPerSegment, out + segment * samplesPerSegment);
+}
+
+// The whole path with every chord within tolerance of the curve. Writes at most capacity points (and their path time
+// to times if it is not null) and returns how many the whole path needs, see SplineTessellation::adaptiveSegment
+inline std::size_t tessellatePathAdaptive(const SplinePath& path, double tolerance, Point* out, std::size_t capacity, double* times = nullptr) {
+    using namespace SplineTessellation;
+    if (!(tolerance > 0)) throw std::invalid_argument("tolerance must be positive.");
+
+    std::size_t count = 0;
+    for (std::size_t index = 0; index < path.getSegmentCount(); ++index) {
+        const SplinePath::Segment& segment = path.getSegment(index);
+        if (index == 0) {
+            if (capacity > 0) {
+                out[0] = segment.c[0];
+                if (times) times[0] = 0;
+            }
+            ++count;
+        }
+        std::size_t first = count;
+        subdivide(segment, 0, segment.c[0], segment.c[1], 1, segment.evaluate(1.0), segment.derivative(1.0), tolerance,
+                  maxSubdivisionDepth, out, times, capacity, count);
+        // subdivide wrote segment times u, map the ones that fit to path times
+        if (times)
+            for (std::size_t i = first; i < std::min(count, capacity); ++i) times[i] = path.getTime(index, times[i]);
+    }
+    return count;
+}
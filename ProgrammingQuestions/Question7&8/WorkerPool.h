@@ -0,0 +1,105 @@
+// Worker threads that live as long as the pool, for work that is split over threads every frame
+//
+// Starting and joining std::threads costs tens of microseconds per thread, which a per frame update pays again every
+// frame. A WorkerPool starts its threads once and parks them on a condition variable between jobs:
+//   WorkerPool workers;                                  // one thread per hardware thread, the caller included
+//   workers.parallelFor(count, 2048, [&](std::size_t begin, std::size_t end) { ... });
+// parallelFor splits [0, count) into one contiguous block per thread (none smaller than minBlock), runs the first block
+// on the calling thread and returns when every block is done. Handing a job over does not allocate.
+// One parallelFor runs at a time: call it from one thread (the game loop), and the work must not throw.
+
+#pragma once
+
+#include <cstddef>
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class WorkerPool {
+private:
+    std::vector<std::thread> threads;
+    std::mutex mutex;
+    std::condition_variable wake;         // workers wait here for the next job
+    std::condition_variable finished;     // parallelFor waits here for the workers
+    std::size_t generation = 0;           // counts the jobs, a worker runs each one once
+    std::size_t pending = 0;              // workers that have not finished the current job
+    bool stopping = false;
+
+    // the current job: work(begin, end) through a plain function pointer, so handing it over needs no std::function
+    void (*invoke)(const void* work, std::size_t begin, std::size_t end) = nullptr;
+    const void* work = nullptr;
+    std::size_t count = 0;
+    std::size_t block = 0;
+    std::size_t blockCount = 0;
+
+    // worker index (1 based, block 0 is the calling thread's) runs its block of every job until the pool stops
+    void run(std::size_t index) {
+        std::size_t seen = 0;
+        std::unique_lock<std::mutex> lock(mutex);
+        for (;;) {
+            wake.wait(lock, [&] { return stopping || generation != seen; });
+            if (stopping) return;
+            seen = generation;
+            if (index < blockCount) {
+                std::size_t begin = std::min(count, index * block), end = std::min(count, (index + 1) * block);
+                lock.unlock();
+                invoke(work, begin, end);
+                lock.lock();
+            }
+            if (--pending == 0) finished.notify_one();
+        }
+    }
+
+public:
+    // threadCount counts the calling thread, 0 uses every hardware thread and 1 runs everything on the caller
+    explicit WorkerPool(unsigned threadCount = 0) {
+        if (threadCount == 0) threadCount = std::max(1u, std::thread::hardware_concurrency());
+        threads.reserve(threadCount - 1);
+        for (unsigned i = 1; i < threadCount; ++i)
+            threads.emplace_back(&WorkerPool::run, this, static_cast<std::size_t>(i));
+    }
+
+    ~WorkerPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (std::thread& thread : threads) thread.join();
+    }
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    unsigned getThreadCount() const { return static_cast<unsigned>(threads.size()) + 1; }
+
+    // Calls work(begin, end) over [0, count) in contiguous blocks of at least minBlock, one per thread at most
+    template <typename Work>
+    void parallelFor(std::size_t count, std::size_t minBlock, const Work& work) {
+        std::size_t blocks = std::min<std::size_t>(threads.size() + 1, std::max<std::size_t>(1, count / std::max<std::size_t>(1, minBlock)));
+        if (blocks <= 1) {
+            work(0, count);
+            return;
+        }
+
+        std::size_t block = (count + blocks - 1) / blocks;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            this->invoke = [](const void* work, std::size_t begin, std::size_t end) { (*static_cast<const Work*>(work))(begin, end); };
+            this->work = &work;
+            this->count = count;
+            this->block = block;
+            this->blockCount = blocks;
+            pending = threads.size();
+            ++generation;
+        }
+        wake.notify_all();
+
+        work(0, std::min(count, block));
+
+        std::unique_lock<std::mutex> lock(mutex);
+        finished.wait(lock, [&] { return pending == 0; });
+    }
+};